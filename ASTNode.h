@@ -9,13 +9,45 @@
 #include <memory>
 #include "ASTVisitor.h"
 #include <sstream>
+#include <cstdint>
 
 template<class T>
 using sptr = std::shared_ptr<T>;
 
+// concrete type of a node, so passes can switch on it instead of going through virtual calls
+enum class ASTNodeKind : uint8_t
+{
+    TranslationUnit,
+    ModuleDefinition,
+    FunctionDefinition,
+    FunctionParameter,
+    VariableDeclaration,
+    ImportStatement,
+
+    Statement,
+    BlockStatement,
+    DeclarationStatement,
+    ExpressionStatement,
+    ReturnStatement,
+
+    Expression,
+    BinaryExpression,
+    FunctionExpression,
+    IntegerExpression,
+    VariableExpression,
+};
+
 class ASTNode
 {
 public:
+    ASTNodeKind kind;
+
+    // value of the slots and indices below that NameResolver hasn't filled in
+    static constexpr uint32_t Unresolved = UINT32_MAX;
+
+    explicit ASTNode(ASTNodeKind kind)
+        : kind(kind) {}
+
     std::string MakeIndent(int indent, int tabWidth) {
         return std::string(indent * tabWidth, ' ');
     }
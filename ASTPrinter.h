@@ -0,0 +1,676 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include "Symbol.h"
+#include "Lexer.h"
+#include "OutputBuffer.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "IntegerExpression.h"
+#include "VariableExpression.h"
+
+// Writes a syntax tree to an OutputBuffer in one of three formats:
+//   Tree:        the indented format of ASTNode::Print, byte for byte
+//   Json:        one object per node, with its kind in "kind", on a single line
+//   SExpression: (module name ...), (function type name (params ...) body), (+ left right), etc.
+class ASTPrinter
+{
+public:
+    enum class Format
+    {
+        Tree,
+        Json,
+        SExpression,
+    };
+
+private:
+    OutputBuffer& out;
+    Format format;
+    int tabWidth;
+
+    // an expression being printed, and the next of its children to print
+    struct PendingExpression
+    {
+        const Expression* expression;
+        int depth;
+        size_t next;
+    };
+
+    std::vector<PendingExpression> pending;
+
+public:
+    ASTPrinter(OutputBuffer& out, Format format = Format::Tree, int tabWidth = 4)
+        : out(out), format(format), tabWidth(tabWidth)
+    {
+    }
+
+    // "tree", "json" or "sexpr"
+    static Format ParseFormat(const std::string& name)
+    {
+        if (name == "tree")
+            return Format::Tree;
+        if (name == "json")
+            return Format::Json;
+        if (name == "sexpr")
+            return Format::SExpression;
+
+        throw std::runtime_error("unknown output format: " + name);
+    }
+
+    void Print(const TranslationUnit& unit)
+    {
+        switch (format)
+        {
+        case Format::Tree:
+            Line(0, "TranslationUnit ", unit.filename);
+            if (unit.rootModule)
+                TreeModule(unit.rootModule, 1);
+            break;
+
+        case Format::Json:
+            out.Write("{\"kind\":\"TranslationUnit\",\"filename\":");
+            JsonString(unit.filename);
+            out.Write(",\"rootModule\":");
+            if (unit.rootModule)
+                JsonModule(unit.rootModule);
+            else
+                out.Write("null");
+            out.Write("}\n");
+            break;
+
+        case Format::SExpression:
+            out.Write("(unit ");
+            SExprString(unit.filename);
+            if (unit.rootModule) {
+                out.Write(' ');
+                SExprModule(unit.rootModule);
+            }
+            out.Write(")\n");
+            break;
+        }
+    }
+
+private:
+
+    static std::string_view OperatorName(TokenType type) {
+        return Lexer::GetTokenName(type);
+    }
+
+    static size_t ChildCount(const Expression* exp)
+    {
+        if (exp->kind == ASTNodeKind::BinaryExpression)
+            return 2;
+        if (exp->kind == ASTNodeKind::FunctionExpression)
+            return static_cast<const FunctionExpression*>(exp)->arguments.size();
+        return 0;
+    }
+
+    static const Expression* GetChild(const Expression* exp, size_t i)
+    {
+        if (exp->kind == ASTNodeKind::BinaryExpression) {
+            auto bin = static_cast<const BinaryExpression*>(exp);
+            return i == 0 ? bin->left : bin->right;
+        }
+
+        return static_cast<const FunctionExpression*>(exp)->arguments[i];
+    }
+
+    // visits the expressions under 'root' depth first, without recursion, since expressions
+    // can nest deeper than the stack allows. 'enter' is called with each expression and its
+    // depth, 'between' before each of its children, with the child's position, and 'leave'
+    // after the last one.
+    template<class Enter, class Between, class Leave>
+    void WalkExpression(const Expression* root, int depth, Enter&& enter, Between&& between, Leave&& leave)
+    {
+        pending.push_back(PendingExpression{ root, depth, 0 });
+        enter(root, depth);
+
+        while (!pending.empty())
+        {
+            auto frame = pending.back();
+
+            if (frame.next == ChildCount(frame.expression)) {
+                leave(frame.expression);
+                pending.pop_back();
+                continue;
+            }
+
+            ++pending.back().next;
+
+            auto child = GetChild(frame.expression, frame.next);
+            between(frame.expression, frame.next);
+            enter(child, frame.depth + 1);
+            pending.push_back(PendingExpression{ child, frame.depth + 1, 0 });
+        }
+    }
+
+    // tree
+
+    void Line(int indent, std::string_view text) {
+        out.WriteSpaces(indent * tabWidth);
+        out.Write(text);
+        out.Write('\n');
+    }
+
+    void Line(int indent, std::string_view text, std::string_view name) {
+        out.WriteSpaces(indent * tabWidth);
+        out.Write(text);
+        out.Write(name);
+        out.Write('\n');
+    }
+
+    void Line(int indent, std::string_view text, Symbol first, Symbol second) {
+        out.WriteSpaces(indent * tabWidth);
+        out.Write(text);
+        out.Write(first.str());
+        out.Write(' ');
+        out.Write(second.str());
+        out.Write('\n');
+    }
+
+    void TreeModule(const ModuleDefinition* mod, int indent)
+    {
+        Line(indent, "ModuleDefinition ", mod->id.str());
+
+        for (auto var : mod->variables)
+            TreeVariable(var, indent + 1);
+
+        for (auto func : mod->functions)
+            TreeFunction(func, indent + 1);
+
+        for (auto nested : mod->modules)
+            TreeModule(nested, indent + 1);
+    }
+
+    void TreeVariable(const VariableDeclaration* var, int indent)
+    {
+        Line(indent, "VariableDeclaration ", var->typeName, var->id);
+
+        if (var->initializer)
+            TreeExpression(var->initializer, indent + 1);
+    }
+
+    void TreeFunction(const FunctionDefinition* func, int indent)
+    {
+        Line(indent, "FunctionDefinition ", func->returnTypeName, func->name);
+
+        for (auto param : func->params)
+            Line(indent + 1, "FunctionParameter ", param->typeName, param->id);
+
+        if (auto body = func->GetBody())
+            TreeStatement(body, indent + 1);
+    }
+
+    void TreeStatement(const Statement* stmt, int indent)
+    {
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            Line(indent, "BlockStatement");
+            for (auto s : static_cast<const BlockStatement*>(stmt)->statements)
+                TreeStatement(s, indent + 1);
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            Line(indent, "DeclarationStatement");
+            auto decl = static_cast<const DeclarationStatement*>(stmt)->variableDeclaration;
+            if (decl)
+                TreeVariable(decl, indent + 1);
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+        {
+            Line(indent, "ExpressionStatement");
+            auto exp = static_cast<const ExpressionStatement*>(stmt)->expression;
+            if (exp)
+                TreeExpression(exp, indent + 1);
+            break;
+        }
+
+        case ASTNodeKind::ReturnStatement:
+        {
+            Line(indent, "ReturnStatement");
+            auto exp = static_cast<const ReturnStatement*>(stmt)->expression;
+            if (exp)
+                TreeExpression(exp, indent + 1);
+            break;
+        }
+
+        default:
+            Line(indent, "Statement");
+            break;
+        }
+    }
+
+    void TreeExpression(const Expression* exp, int indent)
+    {
+        WalkExpression(exp, indent,
+            [this](const Expression* e, int depth) { TreeNode(e, depth); },
+            [](const Expression*, size_t) {},
+            [](const Expression*) {});
+    }
+
+    // the line of 'exp' alone
+    void TreeNode(const Expression* exp, int indent)
+    {
+        switch (exp->kind)
+        {
+        case ASTNodeKind::BinaryExpression:
+            Line(indent, "BinaryExpression ", OperatorName(static_cast<const BinaryExpression*>(exp)->operation));
+            break;
+
+        case ASTNodeKind::FunctionExpression:
+            Line(indent, "FunctionExpression ", static_cast<const FunctionExpression*>(exp)->name.str());
+            break;
+
+        case ASTNodeKind::IntegerExpression:
+            out.WriteSpaces(indent * tabWidth);
+            out.Write("IntegerExpression ");
+            out.WriteInt(static_cast<const IntegerExpression*>(exp)->value);
+            out.Write('\n');
+            break;
+
+        case ASTNodeKind::VariableExpression:
+            Line(indent, "VariableExpression ", static_cast<const VariableExpression*>(exp)->name.str());
+            break;
+
+        default:
+            Line(indent, "Expression");
+            break;
+        }
+    }
+
+    // json
+
+    void JsonString(std::string_view text)
+    {
+        static const char hex[] = "0123456789abcdef";
+
+        out.Write('"');
+
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\') {
+                out.Write('\\');
+                out.Write(c);
+            }
+            else if ((unsigned char)c < 0x20) {
+                out.Write("\\u00");
+                out.Write(hex[(c >> 4) & 0xF]);
+                out.Write(hex[c & 0xF]);
+            }
+            else {
+                out.Write(c);
+            }
+        }
+
+        out.Write('"');
+    }
+
+    // ,"key":"symbol"
+    void JsonField(std::string_view key, Symbol value)
+    {
+        out.Write(",\"");
+        out.Write(key);
+        out.Write("\":");
+        JsonString(value.str());
+    }
+
+    void JsonKey(std::string_view key)
+    {
+        out.Write(",\"");
+        out.Write(key);
+        out.Write("\":");
+    }
+
+    template<class T, class F>
+    void JsonArray(const ArenaArray<T*>& nodes, F&& print)
+    {
+        out.Write('[');
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (i != 0)
+                out.Write(',');
+            print(nodes[i]);
+        }
+
+        out.Write(']');
+    }
+
+    void JsonModule(const ModuleDefinition* mod)
+    {
+        out.Write("{\"kind\":\"ModuleDefinition\"");
+        JsonField("id", mod->id);
+        JsonKey("variables");
+        JsonArray(mod->variables, [this](const VariableDeclaration* v) { JsonVariable(v); });
+        JsonKey("functions");
+        JsonArray(mod->functions, [this](const FunctionDefinition* f) { JsonFunction(f); });
+        JsonKey("modules");
+        JsonArray(mod->modules, [this](const ModuleDefinition* m) { JsonModule(m); });
+        out.Write('}');
+    }
+
+    void JsonVariable(const VariableDeclaration* var)
+    {
+        out.Write("{\"kind\":\"VariableDeclaration\"");
+        JsonField("typeName", var->typeName);
+        JsonField("id", var->id);
+        JsonKey("initializer");
+        JsonExpression(var->initializer);
+        out.Write('}');
+    }
+
+    void JsonFunction(const FunctionDefinition* func)
+    {
+        out.Write("{\"kind\":\"FunctionDefinition\"");
+        JsonField("returnTypeName", func->returnTypeName);
+        JsonField("name", func->name);
+        JsonKey("params");
+
+        JsonArray(func->params, [this](const FunctionParameter* param) {
+            out.Write("{\"kind\":\"FunctionParameter\"");
+            JsonField("typeName", param->typeName);
+            JsonField("id", param->id);
+            out.Write('}');
+        });
+
+        JsonKey("body");
+        JsonStatement(func->GetBody());
+        out.Write('}');
+    }
+
+    void JsonStatement(const Statement* stmt)
+    {
+        if (!stmt) {
+            out.Write("null");
+            return;
+        }
+
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            out.Write("{\"kind\":\"BlockStatement\"");
+            JsonKey("statements");
+            JsonArray(static_cast<const BlockStatement*>(stmt)->statements, [this](const Statement* s) { JsonStatement(s); });
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            out.Write("{\"kind\":\"DeclarationStatement\"");
+            JsonKey("variableDeclaration");
+            auto decl = static_cast<const DeclarationStatement*>(stmt)->variableDeclaration;
+            if (decl)
+                JsonVariable(decl);
+            else
+                out.Write("null");
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+            out.Write("{\"kind\":\"ExpressionStatement\"");
+            JsonKey("expression");
+            JsonExpression(static_cast<const ExpressionStatement*>(stmt)->expression);
+            break;
+
+        case ASTNodeKind::ReturnStatement:
+            out.Write("{\"kind\":\"ReturnStatement\"");
+            JsonKey("expression");
+            JsonExpression(static_cast<const ReturnStatement*>(stmt)->expression);
+            break;
+
+        default:
+            out.Write("{\"kind\":\"Statement\"");
+            break;
+        }
+
+        out.Write('}');
+    }
+
+    void JsonExpression(const Expression* exp)
+    {
+        if (!exp) {
+            out.Write("null");
+            return;
+        }
+
+        WalkExpression(exp, 0,
+            [this](const Expression* e, int) { JsonOpen(e); },
+            [this](const Expression* e, size_t i) {
+                if (e->kind == ASTNodeKind::BinaryExpression)
+                    JsonKey(i == 0 ? "left" : "right");
+                else if (i != 0)
+                    out.Write(',');
+            },
+            [this](const Expression* e) {
+                if (e->kind == ASTNodeKind::FunctionExpression)
+                    out.Write(']');
+                out.Write('}');
+            });
+    }
+
+    // 'exp' up to its children, which it leaves open
+    void JsonOpen(const Expression* exp)
+    {
+        switch (exp->kind)
+        {
+        case ASTNodeKind::BinaryExpression:
+            out.Write("{\"kind\":\"BinaryExpression\",\"operation\":");
+            JsonString(OperatorName(static_cast<const BinaryExpression*>(exp)->operation));
+            break;
+
+        case ASTNodeKind::FunctionExpression:
+            out.Write("{\"kind\":\"FunctionExpression\"");
+            JsonField("name", static_cast<const FunctionExpression*>(exp)->name);
+            JsonKey("arguments");
+            out.Write('[');
+            break;
+
+        case ASTNodeKind::IntegerExpression:
+            out.Write("{\"kind\":\"IntegerExpression\",\"value\":");
+            out.WriteInt(static_cast<const IntegerExpression*>(exp)->value);
+            break;
+
+        case ASTNodeKind::VariableExpression:
+            out.Write("{\"kind\":\"VariableExpression\"");
+            JsonField("name", static_cast<const VariableExpression*>(exp)->name);
+            break;
+
+        default:
+            out.Write("{\"kind\":\"Expression\"");
+            break;
+        }
+    }
+
+    // s-expressions. names are bare atoms, since identifiers can't contain spaces or parentheses.
+
+    void SExprString(std::string_view text)
+    {
+        out.Write('"');
+
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out.Write('\\');
+            out.Write(c);
+        }
+
+        out.Write('"');
+    }
+
+    void Atom(Symbol symbol) {
+        out.Write(' ');
+        out.Write(symbol.str());
+    }
+
+    void SExprModule(const ModuleDefinition* mod)
+    {
+        out.Write("(module");
+        Atom(mod->id);
+
+        for (auto var : mod->variables) {
+            out.Write(' ');
+            SExprVariable(var);
+        }
+
+        for (auto func : mod->functions) {
+            out.Write(' ');
+            SExprFunction(func);
+        }
+
+        for (auto nested : mod->modules) {
+            out.Write(' ');
+            SExprModule(nested);
+        }
+
+        out.Write(')');
+    }
+
+    // (var type name initializer), where a declaration without an initializer has ()
+    void SExprVariable(const VariableDeclaration* var)
+    {
+        out.Write("(var");
+        Atom(var->typeName);
+        Atom(var->id);
+
+        if (var->initializer) {
+            out.Write(' ');
+            SExprExpression(var->initializer);
+        }
+
+        out.Write(')');
+    }
+
+    // (function type name ((type name) ...) body)
+    void SExprFunction(const FunctionDefinition* func)
+    {
+        out.Write("(function");
+        Atom(func->returnTypeName);
+        Atom(func->name);
+        out.Write(" (");
+
+        for (size_t i = 0; i < func->params.size(); ++i)
+        {
+            if (i != 0)
+                out.Write(' ');
+
+            out.Write('(');
+            out.Write(func->params[i]->typeName.str());
+            Atom(func->params[i]->id);
+            out.Write(')');
+        }
+
+        out.Write(')');
+
+        if (auto body = func->GetBody()) {
+            out.Write(' ');
+            SExprStatement(body);
+        }
+
+        out.Write(')');
+    }
+
+    void SExprStatement(const Statement* stmt)
+    {
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            out.Write("(block");
+            for (auto s : static_cast<const BlockStatement*>(stmt)->statements) {
+                out.Write(' ');
+                SExprStatement(s);
+            }
+            out.Write(')');
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto decl = static_cast<const DeclarationStatement*>(stmt)->variableDeclaration;
+            if (decl)
+                SExprVariable(decl);
+            else
+                out.Write("(var)");
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+        case ASTNodeKind::ReturnStatement:
+        {
+            bool isReturn = stmt->kind == ASTNodeKind::ReturnStatement;
+            auto exp = isReturn ? static_cast<const ReturnStatement*>(stmt)->expression
+                                : static_cast<const ExpressionStatement*>(stmt)->expression;
+
+            out.Write(isReturn ? "(return" : "(expr");
+            if (exp) {
+                out.Write(' ');
+                SExprExpression(exp);
+            }
+            out.Write(')');
+            break;
+        }
+
+        default:
+            out.Write("()");
+            break;
+        }
+    }
+
+    // (op left right), (call name args...), integers and variable names as atoms, () for nothing
+    void SExprExpression(const Expression* exp)
+    {
+        WalkExpression(exp, 0,
+            [this](const Expression* e, int) { SExprOpen(e); },
+            [this](const Expression*, size_t) { out.Write(' '); },
+            [this](const Expression* e) {
+                if (e->kind == ASTNodeKind::BinaryExpression || e->kind == ASTNodeKind::FunctionExpression)
+                    out.Write(')');
+            });
+    }
+
+    // 'exp' up to its children, which it leaves open
+    void SExprOpen(const Expression* exp)
+    {
+        switch (exp->kind)
+        {
+        case ASTNodeKind::BinaryExpression:
+            out.Write('(');
+            out.Write(OperatorName(static_cast<const BinaryExpression*>(exp)->operation));
+            break;
+
+        case ASTNodeKind::FunctionExpression:
+            out.Write("(call");
+            Atom(static_cast<const FunctionExpression*>(exp)->name);
+            break;
+
+        case ASTNodeKind::IntegerExpression:
+            out.WriteInt(static_cast<const IntegerExpression*>(exp)->value);
+            break;
+
+        case ASTNodeKind::VariableExpression:
+            out.Write(static_cast<const VariableExpression*>(exp)->name.str());
+            break;
+
+        default:
+            out.Write("()");
+            break;
+        }
+    }
+};
@@ -4,14 +4,50 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include "ASTNode.h"
 
 class ASTNode;
+class TranslationUnit;
+class ModuleDefinition;
+class FunctionDefinition;
+class FunctionParameter;
+class VariableDeclaration;
+class ImportStatement;
+class Statement;
 class BlockStatement;
+class DeclarationStatement;
+class ExpressionStatement;
+class ReturnStatement;
+class Expression;
+class BinaryExpression;
+class FunctionExpression;
+class IntegerExpression;
+class VariableExpression;
 
+// Double dispatch through ASTNode::Accept: every node type calls the Visit overload for itself.
+// Nothing is visited by default. ASTWalker visits children, and StaticASTVisitor does the same
+// without virtual calls.
 class ASTVisitor
 {
 public:
+    virtual ~ASTVisitor() = default;
+
     virtual void Visit(ASTNode* node) {}
+    virtual void Visit(TranslationUnit* node) {}
+    virtual void Visit(ModuleDefinition* node) {}
+    virtual void Visit(FunctionDefinition* node) {}
+    virtual void Visit(FunctionParameter* node) {}
+    virtual void Visit(VariableDeclaration* node) {}
+    virtual void Visit(ImportStatement* node) {}
+
+    virtual void Visit(Statement* node) {}
     virtual void Visit(BlockStatement* node) {}
+    virtual void Visit(DeclarationStatement* node) {}
+    virtual void Visit(ExpressionStatement* node) {}
+    virtual void Visit(ReturnStatement* node) {}
+
+    virtual void Visit(Expression* node) {}
+    virtual void Visit(BinaryExpression* node) {}
+    virtual void Visit(FunctionExpression* node) {}
+    virtual void Visit(IntegerExpression* node) {}
+    virtual void Visit(VariableExpression* node) {}
 };
@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include "ASTVisitor.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "IntegerExpression.h"
+#include "VariableExpression.h"
+
+// ASTVisitor that visits every node under the one it's given, parents before children.
+// Override the Visit functions of the nodes a pass handles, and call ASTWalker::Visit from them
+// to continue into the node's children. Skipped function bodies are parsed on the way.
+class ASTWalker : public ASTVisitor
+{
+public:
+    using ASTVisitor::Visit;
+
+    void Visit(TranslationUnit* node) override
+    {
+        if (node->rootModule)
+            node->rootModule->Accept(this);
+    }
+
+    void Visit(ModuleDefinition* node) override
+    {
+        for (auto var : node->variables)
+            var->Accept(this);
+
+        for (auto func : node->functions)
+            func->Accept(this);
+
+        for (auto mod : node->modules)
+            mod->Accept(this);
+    }
+
+    void Visit(FunctionDefinition* node) override
+    {
+        for (auto param : node->params)
+            param->Accept(this);
+
+        if (auto body = node->GetBody())
+            body->Accept(this);
+    }
+
+    void Visit(VariableDeclaration* node) override
+    {
+        if (node->initializer)
+            node->initializer->Accept(this);
+    }
+
+    void Visit(BlockStatement* node) override
+    {
+        for (auto stmt : node->statements)
+            stmt->Accept(this);
+    }
+
+    void Visit(DeclarationStatement* node) override
+    {
+        if (node->variableDeclaration)
+            node->variableDeclaration->Accept(this);
+    }
+
+    void Visit(ExpressionStatement* node) override
+    {
+        if (node->expression)
+            node->expression->Accept(this);
+    }
+
+    void Visit(ReturnStatement* node) override
+    {
+        if (node->expression)
+            node->expression->Accept(this);
+    }
+
+    void Visit(BinaryExpression* node) override
+    {
+        node->left->Accept(this);
+        node->right->Accept(this);
+    }
+
+    void Visit(FunctionExpression* node) override
+    {
+        for (auto arg : node->arguments)
+            arg->Accept(this);
+    }
+};
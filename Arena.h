@@ -0,0 +1,138 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+
+// Fixed-size array of arena memory, used for the children of AST nodes.
+template<class T>
+struct ArenaArray
+{
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator[](size_t index) const {
+        assert(index < count);
+        return items[index];
+    }
+};
+
+// Bump allocator for objects that all live exactly as long as the arena, like the nodes of an AST.
+// Allocation is a pointer increment, and nothing is destroyed individually: the memory is released
+// in one go with the arena, so only trivially destructible types can be allocated from it.
+class Arena
+{
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cur = nullptr;
+    char* limit = nullptr;
+    size_t allocated = 0;
+
+public:
+    Arena() = default;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // bytes handed out so far
+    size_t size() const {
+        return allocated;
+    }
+
+    void* Allocate(size_t size, size_t align)
+    {
+        assert(align != 0 && (align & (align - 1)) == 0 && align <= alignof(std::max_align_t));
+
+        auto p = (char*)(((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1));
+
+        if (!cur || p > limit || size > (size_t)(limit - p))
+        {
+            // large allocations get a block of their own instead of wasting the current one
+            if (size > BlockSize / 4)
+            {
+                blocks.emplace_back(new char[size]);
+                allocated += size;
+                return blocks.back().get();
+            }
+
+            blocks.emplace_back(new char[BlockSize]);
+            cur = blocks.back().get();
+            limit = cur + BlockSize;
+            p = cur;
+        }
+
+        cur = p + size;
+        allocated += size;
+        return p;
+    }
+
+    template<class T, class... Args>
+    T* New(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // 'count' value-initialized items
+    template<class T>
+    ArenaArray<T> NewArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        assert(count <= UINT32_MAX);
+
+        ArenaArray<T> ret;
+
+        if (count != 0)
+        {
+            ret.items = (T*)Allocate(sizeof(T) * count, alignof(T));
+            ret.count = (uint32_t)count;
+
+            for (size_t i = 0; i < count; ++i)
+                new (ret.items + i) T();
+        }
+
+        return ret;
+    }
+
+    // copies 'count' items into the arena
+    template<class T>
+    ArenaArray<T> NewArray(const T* items, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "arena arrays are copied bytewise");
+        assert(count <= UINT32_MAX);
+
+        ArenaArray<T> ret;
+
+        if (count != 0)
+        {
+            ret.items = (T*)Allocate(sizeof(T) * count, alignof(T));
+            ret.count = (uint32_t)count;
+            memcpy(ret.items, items, sizeof(T) * count);
+        }
+
+        return ret;
+    }
+
+    template<class T>
+    ArenaArray<T> NewArray(const std::vector<T>& items) {
+        return NewArray(items.data(), items.size());
+    }
+};
@@ -0,0 +1,275 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+#include "Pointers.h"
+#include "SourceBuffer.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ThreadPool.h"
+#include "ParseCache.h"
+#include "ASTPrinter.h"
+#include "OutputBuffer.h"
+
+// Parses many translation units on a thread pool.
+// Files are parsed in any order, but their results are written in the order they were given,
+// each as soon as it and all the ones before it are done, so output is deterministic and memory
+// is only held for the files that finished early. Each worker prints its file's tree through
+// its own OutputBuffer before taking the output lock, so trees are formatted in parallel and
+// the lock is only held to copy finished text into the output in order.
+class BatchDriver
+{
+public:
+    struct Options
+    {
+        size_t threadCount = std::thread::hardware_concurrency();
+        bool printTrees = false;
+        ASTPrinter::Format format = ASTPrinter::Format::Tree;
+
+        // extension of the files collected from directories
+        std::string extension = ".src";
+
+        // if set, unchanged files are loaded from a ParseCache in this directory
+        std::string cacheDirectory;
+    };
+
+private:
+    struct Result
+    {
+        bool done = false;
+        bool failed = false;
+        size_t bytes = 0;
+        size_t tokens = 0;
+        double seconds = 0;
+        std::string text; // status line and tree
+    };
+
+    // a worker's text is moved into its result, and the buffer is reused for its next file
+    struct Worker
+    {
+        std::string text;
+        OutputBuffer buffer{ text };
+    };
+
+    Options options;
+    std::vector<std::string> files;
+    uptr<ParseCache> cache;
+
+    OutputBuffer* out = nullptr;
+    std::mutex outputMutex;
+    std::vector<uptr<Worker>> workers;
+    std::vector<Result> results;
+    size_t nextResult = 0;
+
+    size_t failedFiles = 0;
+    size_t totalBytes = 0;
+    size_t totalTokens = 0;
+
+public:
+    BatchDriver()
+    {
+    }
+
+    explicit BatchDriver(const Options& options)
+        : options(options)
+    {
+    }
+
+    // Adds a file, every file with the options' extension under a directory (in sorted order),
+    // or, for "@list", every path listed in the file 'list', one per line.
+    void Add(const std::string& path)
+    {
+        namespace fs = std::filesystem;
+
+        if (!path.empty() && path[0] == '@')
+        {
+            std::ifstream list(path.substr(1));
+            if (!list)
+                throw std::runtime_error("failed to open file list: " + path.substr(1));
+
+            std::string line;
+            while (std::getline(list, line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+
+                if (!line.empty())
+                    Add(line);
+            }
+        }
+        else if (fs::is_directory(path))
+        {
+            std::vector<std::string> found;
+
+            for (auto& entry : fs::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == options.extension)
+                    found.push_back(entry.path().string());
+            }
+
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        else
+        {
+            files.push_back(path);
+        }
+    }
+
+    size_t fileCount() const {
+        return files.size();
+    }
+
+    // parses every file added so far, and writes a line per file and a summary to 'output',
+    // which is flushed when it fills up and at the end. returns the number of files that failed
+    // to parse.
+    size_t Run(OutputBuffer& output)
+    {
+        out = &output;
+        results.assign(files.size(), Result());
+        nextResult = 0;
+        failedFiles = totalBytes = totalTokens = 0;
+
+        if (!options.cacheDirectory.empty() && !cache)
+            cache.reset(new ParseCache(options.cacheDirectory));
+
+        auto cacheStart = cache ? cache->statistics() : ParseCache::Statistics();
+
+        ThreadPool pool(options.threadCount);
+
+        workers.resize(pool.size());
+        for (auto& worker : workers) {
+            if (!worker)
+                worker.reset(new Worker());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        pool.ForEach(files.size(), [this](size_t i, size_t worker) {
+            ParseFile(i, *workers[worker]);
+        });
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::stringstream stream;
+        stream << files.size() << " files (" << failedFiles << " failed), "
+               << std::fixed << std::setprecision(1) << totalBytes / 1e6 << " MB, "
+               << totalTokens << " tokens in " << std::setprecision(3) << seconds << " s on "
+               << pool.size() << " threads";
+
+        // no rates for an empty run, or one too short for the clock to measure
+        if (seconds > 0 && !files.empty())
+        {
+            stream << ": " << std::setprecision(1) << files.size() / seconds << " files/s, "
+                   << totalBytes / seconds / 1e6 << " MB/s, "
+                   << totalTokens / seconds / 1e6 << " M tokens/s";
+        }
+
+        stream << std::endl;
+
+        if (cache)
+        {
+            auto stats = cache->statistics();
+            stream << "cache: " << stats.hits - cacheStart.hits << " hits, " << stats.misses - cacheStart.misses << " misses, "
+                   << (stats.bytesLoaded - cacheStart.bytesLoaded) / 1e6 << " MB loaded, "
+                   << (stats.bytesStored - cacheStart.bytesStored) / 1e6 << " MB stored" << std::endl;
+        }
+
+        output.Write(stream.str());
+        output.Flush();
+        out = nullptr;
+        return failedFiles;
+    }
+
+private:
+
+    void ParseFile(size_t index, Worker& worker)
+    {
+        Result result;
+        std::stringstream stream;
+        sptr<TranslationUnit> tree;
+
+        auto start = std::chrono::steady_clock::now();
+
+        try
+        {
+            auto source = SourceBuffer::FromFile(files[index]);
+            result.bytes = source->size();
+
+            auto translationUnit = cache ? cache->Load(*source) : nullptr;
+            bool cached = translationUnit != nullptr;
+
+            if (!cached)
+            {
+                auto tokens = Lexer::TokenizeStream(source);
+                result.tokens = tokens.size();
+
+                Parser parser(std::move(tokens));
+                translationUnit = parser.ParseTranslationUnit();
+
+                if (cache)
+                    cache->Store(*source, *translationUnit);
+            }
+
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            stream << files[index] << ": " << result.bytes << " bytes, ";
+
+            if (cached)
+                stream << "cached, ";
+            else
+                stream << result.tokens << " tokens, ";
+
+            stream
+                   << std::fixed << std::setprecision(3) << result.seconds * 1e3 << " ms, "
+                   << std::setprecision(1) << result.bytes / result.seconds / 1e6 << " MB/s" << std::endl;
+
+            if (options.printTrees)
+                tree = translationUnit;
+        }
+        catch (std::exception& ex)
+        {
+            // lexer and parser errors start with the file name already
+            result.failed = true;
+            stream << ex.what() << std::endl;
+        }
+
+        worker.buffer.Write(stream.str());
+
+        if (tree)
+            ASTPrinter(worker.buffer, options.format, 2).Print(*tree);
+
+        worker.buffer.Flush();
+        result.text = std::move(worker.text);
+        worker.text.clear();
+        result.done = true;
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        results[index] = std::move(result);
+
+        // write out every result that's no longer waiting on an earlier one
+        for (; nextResult < results.size() && results[nextResult].done; ++nextResult)
+        {
+            auto& next = results[nextResult];
+            out->Write(next.text);
+
+            failedFiles += next.failed;
+            totalBytes += next.bytes;
+            totalTokens += next.tokens;
+
+            next.text = std::string();
+        }
+    }
+};
@@ -11,14 +11,18 @@ class BinaryExpression : public Expression
 {
 public:
     TokenType operation;
-    sptr<Expression> left;
-    sptr<Expression> right;
+    Expression* left;
+    Expression* right;
 
-    BinaryExpression(TokenType op, const sptr<Expression>& left, const sptr<Expression>& right)
-        : operation(op), left(left), right(right)
+    BinaryExpression(TokenType op, Expression* left, Expression* right)
+        : Expression(ASTNodeKind::BinaryExpression), operation(op), left(left), right(right)
     {
     }
 
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
+
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
         stream << MakeIndent(indent, tabWidth) << "BinaryExpression " << Lexer::GetTokenName(operation) << std::endl;
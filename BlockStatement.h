@@ -4,13 +4,20 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <vector>
+#include "Arena.h"
 #include "Statement.h"
 
 class BlockStatement : public Statement
 {
 public:
-    std::vector<sptr<Statement>> statements;
+    ArenaArray<Statement*> statements;
+
+    BlockStatement()
+        : Statement(ASTNodeKind::BlockStatement) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
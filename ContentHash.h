@@ -0,0 +1,75 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Fast 64 bit hash of a block of bytes, for recognizing content that was seen before.
+// Not cryptographic. Four independent lanes each take 8 bytes per round, so the multiplies
+// overlap and large inputs hash at several bytes per cycle.
+namespace ContentHash
+{
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+
+    inline uint64_t Load64(const unsigned char* p)
+    {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t Rotate(uint64_t x, int bits) {
+        return (x << bits) | (x >> (64 - bits));
+    }
+
+    inline uint64_t Round(uint64_t lane, uint64_t input) {
+        return Rotate(lane + input * Prime2, 31) * Prime1;
+    }
+
+    // spreads every input bit over the whole result
+    inline uint64_t Finish(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    inline uint64_t Compute(const void* data, size_t size, uint64_t seed = 0)
+    {
+        auto p = (const unsigned char*)data;
+        auto end = p + size;
+
+        uint64_t lanes[4] = { seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 };
+
+        for (; end - p >= 32; p += 32)
+        {
+            lanes[0] = Round(lanes[0], Load64(p));
+            lanes[1] = Round(lanes[1], Load64(p + 8));
+            lanes[2] = Round(lanes[2], Load64(p + 16));
+            lanes[3] = Round(lanes[3], Load64(p + 24));
+        }
+
+        uint64_t h = Rotate(lanes[0], 1) + Rotate(lanes[1], 7) + Rotate(lanes[2], 12) + Rotate(lanes[3], 18);
+        h += (uint64_t)size * Prime1;
+
+        for (; end - p >= 8; p += 8)
+            h = Rotate(h ^ Round(0, Load64(p)), 27) * Prime1 + Prime2;
+
+        if (p != end)
+        {
+            uint64_t tail = 0;
+            memcpy(&tail, p, end - p);
+            h = Rotate(h ^ Round(0, tail), 27) * Prime1 + Prime2;
+        }
+
+        return Finish(h);
+    }
+}
@@ -10,7 +10,14 @@
 class DeclarationStatement : public Statement
 {
 public:
-    sptr<VariableDeclaration> variableDeclaration;
+    VariableDeclaration* variableDeclaration = nullptr;
+
+    DeclarationStatement()
+        : Statement(ASTNodeKind::DeclarationStatement) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
@@ -5,10 +5,21 @@
 
 #pragma once
 #include "ASTNode.h"
+#include "TypeTable.h"
 
 class Expression : public ASTNode
 {
 public:
+    // type of the value, set by TypeChecker
+    TypeId type = TypeTable::Error;
+
+    explicit Expression(ASTNodeKind kind = ASTNodeKind::Expression)
+        : ASTNode(kind) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
+
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
         stream << MakeIndent(indent, tabWidth) << "Expression" << std::endl;
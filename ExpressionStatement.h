@@ -4,14 +4,20 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <memory>
 #include "Statement.h"
 #include "Expression.h"
 
 class ExpressionStatement : public Statement
 {
 public:
-    sptr<Expression> expression;
+    Expression* expression = nullptr;
+
+    ExpressionStatement()
+        : Statement(ASTNodeKind::ExpressionStatement) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
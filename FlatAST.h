@@ -0,0 +1,996 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <stdexcept>
+#include <unordered_map>
+#include "Pointers.h"
+#include "ContentHash.h"
+#include "Symbol.h"
+#include "TokenType.h"
+#include "Lexer.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "IntegerExpression.h"
+#include "VariableExpression.h"
+
+// Compact, index-based copy of an AST for passes that walk the whole tree.
+// Nodes are plain structs in one contiguous array per category, referenced by 32 bit indices.
+// Expressions and statements carry their ASTNodeKind as a tag byte, and lists of children are
+// ranges of the shared 'children' array, so a pass over the expressions streams through memory
+// instead of chasing pointers between heap objects.
+class FlatAST
+{
+public:
+    using Index = uint32_t;
+    static constexpr Index None = UINT32_MAX;
+
+    // 'count' indices in 'children', starting at 'first'
+    struct Range
+    {
+        Index first = 0;
+        Index count = 0;
+    };
+
+    // 16 bytes. the meaning of a, b and c depends on the kind:
+    //   BinaryExpression:   left and right expression
+    //   FunctionExpression: name symbol, and the range of argument expressions
+    //   IntegerExpression:  value
+    //   VariableExpression: name symbol
+    //   Expression:         nothing (a declaration without an initializer)
+    struct Expr
+    {
+        ASTNodeKind kind;
+        TokenType operation; // BinaryExpression only
+        Index a;
+        Index b;
+        Index c;
+
+        Index left() const { return a; }
+        Index right() const { return b; }
+        Symbol name() const { return Symbol(a); }
+        Range arguments() const { return Range{ b, c }; }
+        int value() const { return (int)a; }
+    };
+
+    // 12 bytes:
+    //   BlockStatement:       the range of statements
+    //   DeclarationStatement: index of the variable
+    //   ExpressionStatement, ReturnStatement: the expression, or None
+    struct Stmt
+    {
+        ASTNodeKind kind;
+        Index a;
+        Index b;
+
+        Range statements() const { return Range{ a, b }; }
+        Index variable() const { return a; }
+        Index expression() const { return a; }
+    };
+
+    static_assert(sizeof(Expr) == 16 && sizeof(Stmt) == 12, "flat nodes should stay compact");
+
+    struct Variable
+    {
+        Symbol typeName;
+        Symbol id;
+        Index initializer; // expression, or None
+    };
+
+    struct Parameter
+    {
+        Symbol typeName;
+        Symbol id;
+    };
+
+    struct Function
+    {
+        Symbol returnTypeName;
+        Symbol name;
+        Range params;
+        Index body; // statement, or None
+    };
+
+    struct Module
+    {
+        Symbol id;
+        Range variables;
+        Range functions;
+        Range modules;
+    };
+
+    std::string filename;
+    std::vector<Expr> expressions;
+    std::vector<Stmt> statements;
+    std::vector<Variable> variables;
+    std::vector<Parameter> params;
+    std::vector<Function> functions;
+    std::vector<Module> modules;
+    std::vector<Index> children;
+    Index rootModule = None;
+
+    Index child(Range range, size_t i) const {
+        assert(i < range.count);
+        return children[range.first + i];
+    }
+
+    static FlatAST FromTree(const TranslationUnit& unit)
+    {
+        FlatAST ast;
+        ast.filename = unit.filename;
+
+        if (unit.rootModule)
+            ast.rootModule = ast.Add(unit.rootModule);
+
+        return ast;
+    }
+
+    // same output as TranslationUnit::Print
+    void Print(std::stringstream& stream, int indent = 0, int tabWidth = 4) const
+    {
+        stream << Indent(indent, tabWidth) << "TranslationUnit " << filename << std::endl;
+
+        if (rootModule != None)
+            PrintModule(stream, rootModule, indent + 1, tabWidth);
+    }
+
+    // rebuilds the tree, in a new translation unit
+    sptr<TranslationUnit> ToTree() const
+    {
+        auto unit = spnew<TranslationUnit>();
+        unit->filename = filename;
+
+        if (rootModule != None)
+            unit->rootModule = BuildModule(unit->arena, rootModule);
+
+        return unit;
+    }
+
+    // Binary form: a FileHeader, the file name, the symbol names, then every array byte for byte.
+    // Symbol ids are only meaningful in the process that interned them, so in the file they are
+    // indices into the names. Loading interns each name once and rewrites the symbol fields,
+    // which is the only fix-up needed; everything else is already index based.
+    static constexpr uint32_t FileVersion = 2;
+
+    struct FileHeader
+    {
+        char magic[4];           // "FAST"
+        uint32_t version;        // FileVersion
+        uint32_t byteOrder;      // 0x01020304, as written by the machine that saved it
+        uint32_t filenameLength;
+        uint32_t symbolCount;    // names, not counting the empty one
+        uint32_t symbolBytes;
+        uint32_t counts[7];      // expressions, statements, variables, params, functions, modules, children
+        Index rootModule;
+        uint64_t fileHash;       // see HashFile
+    };
+
+    std::string Serialize() const
+    {
+        // symbol ids become 1-based indices into 'names', in order of first use
+        FlatAST copy = *this;
+        std::unordered_map<uint32_t, uint32_t> indices{ { 0, 0 } };
+        std::vector<std::string_view> names;
+
+        copy.ForEachSymbol([&](uint32_t& id) {
+            auto it = indices.emplace(id, (uint32_t)names.size() + 1);
+            if (it.second)
+                names.push_back(Symbol(id).str());
+            id = it.first->second;
+        });
+
+        std::string payload = filename;
+
+        for (auto& name : names)
+            AppendBytes(payload, (uint32_t)name.size());
+
+        size_t symbolBytes = 0;
+        for (auto& name : names) {
+            payload.append(name.data(), name.size());
+            symbolBytes += name.size();
+        }
+
+        payload.resize((payload.size() + 3) & ~(size_t)3);
+
+        copy.ForEachArray([&](auto& array) {
+            AppendNodes(payload, array);
+        });
+
+        FileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "FAST", 4);
+        header.version = FileVersion;
+        header.byteOrder = 0x01020304;
+        header.filenameLength = (uint32_t)filename.size();
+        header.symbolCount = (uint32_t)names.size();
+        header.symbolBytes = (uint32_t)symbolBytes;
+        header.rootModule = rootModule;
+
+        size_t i = 0;
+        copy.ForEachArray([&](auto& array) {
+            header.counts[i++] = (uint32_t)array.size();
+        });
+
+        std::string ret((const char*)&header, sizeof(header));
+        ret += payload;
+
+        auto hash = HashFile(ret.data(), ret.size());
+        memcpy(&ret[offsetof(FileHeader, fileHash)], &hash, sizeof(hash));
+        return ret;
+    }
+
+    // throws std::runtime_error if 'data' isn't a complete, intact file of this version
+    static FlatAST Deserialize(const char* data, size_t size)
+    {
+        FileHeader header;
+
+        if (size < sizeof(header))
+            throw std::runtime_error("invalid AST file: too short");
+
+        memcpy(&header, data, sizeof(header));
+
+        if (memcmp(header.magic, "FAST", 4) != 0)
+            throw std::runtime_error("invalid AST file: bad signature");
+
+        if (header.version != FileVersion || header.byteOrder != 0x01020304)
+            throw std::runtime_error("invalid AST file: unsupported version or byte order");
+
+        auto payload = data + sizeof(header);
+        auto p = payload;
+        auto end = data + size;
+
+        if (HashFile(data, size) != header.fileHash)
+            throw std::runtime_error("invalid AST file: corrupt or truncated");
+
+        auto take = [&](size_t bytes) {
+            if ((size_t)(end - p) < bytes)
+                throw std::runtime_error("invalid AST file: truncated");
+            auto ret = p;
+            p += bytes;
+            return ret;
+        };
+
+        FlatAST ast;
+        ast.filename.assign(take(header.filenameLength), header.filenameLength);
+        ast.rootModule = header.rootModule;
+
+        auto lengths = take(header.symbolCount * sizeof(uint32_t));
+        auto text = take(header.symbolBytes);
+
+        // symbol index -> id in this process
+        std::vector<uint32_t> ids((size_t)header.symbolCount + 1);
+        auto textEnd = text + header.symbolBytes;
+
+        for (uint32_t i = 0; i < header.symbolCount; ++i)
+        {
+            uint32_t length;
+            memcpy(&length, lengths + i * sizeof(uint32_t), sizeof(length));
+
+            if (length > (size_t)(textEnd - text))
+                throw std::runtime_error("invalid AST file: bad symbol");
+
+            ids[i + 1] = Symbol::Intern(std::string_view(text, length)).id;
+            text += length;
+        }
+
+        // arrays start 4 byte aligned within the payload
+        take((4 - (p - payload) % 4) % 4);
+
+        size_t i = 0;
+        ast.ForEachArray([&](auto& array) {
+            // checked before resizing, so a damaged count can't allocate more than the file holds
+            auto count = header.counts[i++];
+            if (count > (size_t)(end - p) / sizeof(array[0]))
+                throw std::runtime_error("invalid AST file: truncated");
+
+            array.resize(count);
+            auto bytes = array.size() * sizeof(array[0]);
+            auto from = take(bytes);
+            if (bytes != 0)
+                memcpy((void*)array.data(), from, bytes);
+        });
+
+        ast.ForEachSymbol([&](uint32_t& id) {
+            if (id >= ids.size())
+                throw std::runtime_error("invalid AST file: bad symbol");
+            id = ids[id];
+        });
+
+        ast.Validate();
+        return ast;
+    }
+
+private:
+
+    // calls fn on every array of nodes, in file order
+    template<class F>
+    void ForEachArray(F&& fn)
+    {
+        fn(expressions);
+        fn(statements);
+        fn(variables);
+        fn(params);
+        fn(functions);
+        fn(modules);
+        fn(children);
+    }
+
+    // calls fn on the id of every symbol field
+    template<class F>
+    void ForEachSymbol(F&& fn)
+    {
+        for (auto& exp : expressions)
+        {
+            if (exp.kind == ASTNodeKind::FunctionExpression || exp.kind == ASTNodeKind::VariableExpression)
+                fn(exp.a);
+        }
+
+        for (auto& var : variables) {
+            fn(var.typeName.id);
+            fn(var.id.id);
+        }
+
+        for (auto& param : params) {
+            fn(param.typeName.id);
+            fn(param.id.id);
+        }
+
+        for (auto& func : functions) {
+            fn(func.returnTypeName.id);
+            fn(func.name.id);
+        }
+
+        for (auto& mod : modules)
+            fn(mod.id.id);
+    }
+
+    template<class T>
+    static void AppendBytes(std::string& bytes, const T& value) {
+        bytes.append((const char*)&value, sizeof(value));
+    }
+
+    // ContentHash of a whole file, with the fileHash field taken as zero
+    static uint64_t HashFile(const char* data, size_t size)
+    {
+        char header[sizeof(FileHeader)];
+        memcpy(header, data, sizeof(header));
+        memset(header + offsetof(FileHeader, fileHash), 0, sizeof(FileHeader::fileHash));
+
+        auto seed = ContentHash::Compute(header, sizeof(header));
+        return ContentHash::Compute(data + sizeof(header), size - sizeof(header), seed);
+    }
+
+    template<class T>
+    static void AppendNodes(std::string& bytes, const std::vector<T>& nodes)
+    {
+        static_assert(std::has_unique_object_representations<T>::value, "nodes with padding need their own overload");
+        bytes.append((const char*)nodes.data(), nodes.size() * sizeof(T));
+    }
+
+    // Expr and Stmt have padding after their tag bytes, which is written as zeros so that
+    // equal trees serialize to equal bytes
+    static void AppendNodes(std::string& bytes, const std::vector<Expr>& nodes)
+    {
+        auto out = bytes.size();
+        bytes.resize(out + nodes.size() * sizeof(Expr));
+
+        for (auto& exp : nodes)
+        {
+            auto dst = &bytes[out];
+            memcpy(dst + offsetof(Expr, kind), &exp.kind, sizeof(exp.kind));
+            memcpy(dst + offsetof(Expr, operation), &exp.operation, sizeof(exp.operation));
+            memcpy(dst + offsetof(Expr, a), &exp.a, sizeof(exp.a));
+            memcpy(dst + offsetof(Expr, b), &exp.b, sizeof(exp.b));
+            memcpy(dst + offsetof(Expr, c), &exp.c, sizeof(exp.c));
+            out += sizeof(Expr);
+        }
+    }
+
+    static void AppendNodes(std::string& bytes, const std::vector<Stmt>& nodes)
+    {
+        auto out = bytes.size();
+        bytes.resize(out + nodes.size() * sizeof(Stmt));
+
+        for (auto& stmt : nodes)
+        {
+            auto dst = &bytes[out];
+            memcpy(dst + offsetof(Stmt, kind), &stmt.kind, sizeof(stmt.kind));
+            memcpy(dst + offsetof(Stmt, a), &stmt.a, sizeof(stmt.a));
+            memcpy(dst + offsetof(Stmt, b), &stmt.b, sizeof(stmt.b));
+            out += sizeof(Stmt);
+        }
+    }
+
+    // throws unless every index is in range and every node has at most one parent, which the
+    // root module doesn't, so a loaded file can be followed without checks and has no cycles
+    void Validate() const
+    {
+        auto fail = [] {
+            throw std::runtime_error("invalid AST file: bad node index");
+        };
+
+        std::vector<uint8_t> usedExpressions(expressions.size());
+        std::vector<uint8_t> usedStatements(statements.size());
+        std::vector<uint8_t> usedVariables(variables.size());
+        std::vector<uint8_t> usedParams(params.size());
+        std::vector<uint8_t> usedFunctions(functions.size());
+        std::vector<uint8_t> usedModules(modules.size());
+
+        auto use = [&](std::vector<uint8_t>& used, Index index) {
+            if (index >= used.size() || used[index]++ != 0)
+                fail();
+        };
+
+        auto useOptional = [&](std::vector<uint8_t>& used, Index index) {
+            if (index != None)
+                use(used, index);
+        };
+
+        auto useRange = [&](std::vector<uint8_t>& used, Range range) {
+            if (range.first > children.size() || range.count > children.size() - range.first)
+                fail();
+
+            for (Index i = 0; i < range.count; ++i)
+                use(used, children[range.first + i]);
+        };
+
+        for (auto& exp : expressions)
+        {
+            if (exp.kind == ASTNodeKind::BinaryExpression)
+            {
+                if ((int)exp.operation < (int)TokenType::Invalid || (int)exp.operation > (int)TokenType::Return)
+                    fail();
+
+                use(usedExpressions, exp.left());
+                use(usedExpressions, exp.right());
+            }
+            else if (exp.kind == ASTNodeKind::FunctionExpression)
+            {
+                useRange(usedExpressions, exp.arguments());
+            }
+        }
+
+        for (auto& stmt : statements)
+        {
+            switch (stmt.kind)
+            {
+            case ASTNodeKind::BlockStatement:
+                useRange(usedStatements, stmt.statements());
+                break;
+            case ASTNodeKind::DeclarationStatement:
+                useOptional(usedVariables, stmt.variable());
+                break;
+            case ASTNodeKind::ExpressionStatement:
+            case ASTNodeKind::ReturnStatement:
+                useOptional(usedExpressions, stmt.expression());
+                break;
+            default:
+                break;
+            }
+        }
+
+        for (auto& var : variables)
+            useOptional(usedExpressions, var.initializer);
+
+        for (auto& func : functions) {
+            useRange(usedParams, func.params);
+            useOptional(usedStatements, func.body);
+        }
+
+        for (auto& mod : modules) {
+            useRange(usedVariables, mod.variables);
+            useRange(usedFunctions, mod.functions);
+            useRange(usedModules, mod.modules);
+        }
+
+        useOptional(usedModules, rootModule);
+    }
+
+    template<class T, class F>
+    ArenaArray<T*> BuildAll(Arena& arena, Range range, F&& build) const
+    {
+        auto nodes = arena.NewArray<T*>(range.count);
+
+        for (Index i = 0; i < range.count; ++i)
+            nodes.items[i] = build(child(range, i));
+
+        return nodes;
+    }
+
+    ModuleDefinition* BuildModule(Arena& arena, Index index) const
+    {
+        auto& mod = modules[index];
+        auto ret = arena.New<ModuleDefinition>(mod.id);
+        ret->variables = BuildAll<VariableDeclaration>(arena, mod.variables, [&](Index i) { return BuildVariable(arena, i); });
+        ret->functions = BuildAll<FunctionDefinition>(arena, mod.functions, [&](Index i) { return BuildFunction(arena, i); });
+        ret->modules = BuildAll<ModuleDefinition>(arena, mod.modules, [&](Index i) { return BuildModule(arena, i); });
+        return ret;
+    }
+
+    VariableDeclaration* BuildVariable(Arena& arena, Index index) const
+    {
+        auto& var = variables[index];
+        auto ret = arena.New<VariableDeclaration>();
+        ret->typeName = var.typeName;
+        ret->id = var.id;
+        ret->initializer = var.initializer != None ? BuildExpression(arena, var.initializer) : nullptr;
+        return ret;
+    }
+
+    FunctionDefinition* BuildFunction(Arena& arena, Index index) const
+    {
+        auto& func = functions[index];
+        auto ret = arena.New<FunctionDefinition>();
+        ret->returnTypeName = func.returnTypeName;
+        ret->name = func.name;
+
+        ret->params = BuildAll<FunctionParameter>(arena, func.params, [&](Index i) {
+            auto param = arena.New<FunctionParameter>();
+            param->typeName = params[i].typeName;
+            param->id = params[i].id;
+            return param;
+        });
+
+        ret->SetBody(func.body != None ? BuildStatement(arena, func.body) : nullptr);
+        return ret;
+    }
+
+    Statement* BuildStatement(Arena& arena, Index index) const
+    {
+        auto& stmt = statements[index];
+
+        switch (stmt.kind)
+        {
+        case ASTNodeKind::BlockStatement:
+        {
+            auto ret = arena.New<BlockStatement>();
+            ret->statements = BuildAll<Statement>(arena, stmt.statements(), [&](Index i) { return BuildStatement(arena, i); });
+            return ret;
+        }
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto ret = arena.New<DeclarationStatement>();
+            ret->variableDeclaration = stmt.variable() != None ? BuildVariable(arena, stmt.variable()) : nullptr;
+            return ret;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+        {
+            auto ret = arena.New<ExpressionStatement>();
+            ret->expression = stmt.expression() != None ? BuildExpression(arena, stmt.expression()) : nullptr;
+            return ret;
+        }
+
+        case ASTNodeKind::ReturnStatement:
+        {
+            auto ret = arena.New<ReturnStatement>();
+            ret->expression = stmt.expression() != None ? BuildExpression(arena, stmt.expression()) : nullptr;
+            return ret;
+        }
+
+        default:
+            return arena.New<Statement>();
+        }
+    }
+
+    // iterative, like Add(const Expression*)
+    Expression* BuildExpression(Arena& arena, Index root) const
+    {
+        struct PendingExpression
+        {
+            Index index;
+            bool childrenBuilt;
+        };
+
+        std::vector<PendingExpression> pending;
+        std::vector<Expression*> built;
+
+        pending.push_back(PendingExpression{ root, false });
+
+        while (!pending.empty())
+        {
+            auto item = pending.back();
+            auto& exp = expressions[item.index];
+
+            if (!item.childrenBuilt)
+            {
+                pending.back().childrenBuilt = true;
+
+                if (exp.kind == ASTNodeKind::BinaryExpression)
+                {
+                    pending.push_back(PendingExpression{ exp.right(), false });
+                    pending.push_back(PendingExpression{ exp.left(), false });
+                }
+                else if (exp.kind == ASTNodeKind::FunctionExpression)
+                {
+                    for (auto i = exp.arguments().count; i-- > 0; )
+                        pending.push_back(PendingExpression{ child(exp.arguments(), i), false });
+                }
+
+                continue;
+            }
+
+            pending.pop_back();
+
+            Expression* ret;
+
+            switch (exp.kind)
+            {
+            case ASTNodeKind::BinaryExpression:
+            {
+                auto right = built.back();
+                built.pop_back();
+                auto left = built.back();
+                built.pop_back();
+                ret = arena.New<BinaryExpression>(exp.operation, left, right);
+                break;
+            }
+
+            case ASTNodeKind::FunctionExpression:
+            {
+                auto count = exp.arguments().count;
+                auto call = arena.New<FunctionExpression>();
+                call->name = exp.name();
+                call->arguments = arena.NewArray<Expression*>(built.data() + built.size() - count, count);
+                built.resize(built.size() - count);
+                ret = call;
+                break;
+            }
+
+            case ASTNodeKind::IntegerExpression:
+                ret = arena.New<IntegerExpression>(exp.value());
+                break;
+
+            case ASTNodeKind::VariableExpression:
+            {
+                auto var = arena.New<VariableExpression>();
+                var->name = exp.name();
+                ret = var;
+                break;
+            }
+
+            default:
+                ret = arena.New<Expression>();
+                break;
+            }
+
+            built.push_back(ret);
+        }
+
+        return built.back();
+    }
+
+    // reserves 'count' slots in 'children', to be filled after the children themselves are added
+    Range AddRange(size_t count)
+    {
+        Range range{ (Index)children.size(), (Index)count };
+        children.resize(children.size() + count);
+        return range;
+    }
+
+    template<class T, class F>
+    Range AddAll(const ArenaArray<T*>& nodes, F&& add)
+    {
+        auto range = AddRange(nodes.size());
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            auto index = add(nodes[i]);
+            children[range.first + i] = index;
+        }
+
+        return range;
+    }
+
+    Index Add(const ModuleDefinition* mod)
+    {
+        auto index = (Index)modules.size();
+        modules.push_back(Module{ mod->id, Range(), Range(), Range() });
+
+        auto vars = AddAll(mod->variables, [this](const VariableDeclaration* v) { return Add(v); });
+        auto funcs = AddAll(mod->functions, [this](const FunctionDefinition* f) { return Add(f); });
+        auto mods = AddAll(mod->modules, [this](const ModuleDefinition* m) { return Add(m); });
+
+        // 'modules' may have grown since
+        auto& module = modules[index];
+        module.variables = vars;
+        module.functions = funcs;
+        module.modules = mods;
+        return index;
+    }
+
+    Index Add(const VariableDeclaration* var)
+    {
+        auto initializer = var->initializer ? Add(var->initializer) : None;
+        variables.push_back(Variable{ var->typeName, var->id, initializer });
+        return (Index)variables.size() - 1;
+    }
+
+    Index Add(const FunctionDefinition* func)
+    {
+        auto paramRange = AddAll(func->params, [this](const FunctionParameter* p) {
+            params.push_back(Parameter{ p->typeName, p->id });
+            return (Index)params.size() - 1;
+        });
+
+        auto body = func->GetBody() ? Add(func->GetBody()) : None;
+        functions.push_back(Function{ func->returnTypeName, func->name, paramRange, body });
+        return (Index)functions.size() - 1;
+    }
+
+    Index Add(const Statement* stmt)
+    {
+        Stmt ret{ stmt->kind, None, 0 };
+
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+        {
+            auto range = AddAll(static_cast<const BlockStatement*>(stmt)->statements,
+                                [this](const Statement* s) { return Add(s); });
+            ret.a = range.first;
+            ret.b = range.count;
+            break;
+        }
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto decl = static_cast<const DeclarationStatement*>(stmt)->variableDeclaration;
+            ret.a = decl ? Add(decl) : None;
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+        {
+            auto exp = static_cast<const ExpressionStatement*>(stmt)->expression;
+            ret.a = exp ? Add(exp) : None;
+            break;
+        }
+
+        case ASTNodeKind::ReturnStatement:
+        {
+            auto exp = static_cast<const ReturnStatement*>(stmt)->expression;
+            ret.a = exp ? Add(exp) : None;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        statements.push_back(ret);
+        return (Index)statements.size() - 1;
+    }
+
+    // iterative, since expressions can nest deeper than the stack allows. children are added
+    // before their parent, in the same order a recursive walk would add them.
+    Index Add(const Expression* root)
+    {
+        struct PendingExpression
+        {
+            const Expression* expression;
+            Range arguments; // reserved when a call is first visited
+            bool childrenAdded;
+        };
+
+        std::vector<PendingExpression> pending;
+        std::vector<Index> added;
+
+        pending.push_back(PendingExpression{ root, Range(), false });
+
+        while (!pending.empty())
+        {
+            auto item = pending.back();
+            auto exp = item.expression;
+
+            if (!item.childrenAdded)
+            {
+                pending.back().childrenAdded = true;
+
+                if (exp->kind == ASTNodeKind::BinaryExpression)
+                {
+                    auto bin = static_cast<const BinaryExpression*>(exp);
+                    pending.push_back(PendingExpression{ bin->right, Range(), false });
+                    pending.push_back(PendingExpression{ bin->left, Range(), false });
+                }
+                else if (exp->kind == ASTNodeKind::FunctionExpression)
+                {
+                    auto& args = static_cast<const FunctionExpression*>(exp)->arguments;
+                    pending.back().arguments = AddRange(args.size());
+
+                    for (auto i = args.size(); i-- > 0; )
+                        pending.push_back(PendingExpression{ args[i], Range(), false });
+                }
+
+                continue;
+            }
+
+            pending.pop_back();
+
+            Expr ret{ exp->kind, TokenType::Invalid, 0, 0, 0 };
+
+            switch (exp->kind)
+            {
+            case ASTNodeKind::BinaryExpression:
+                ret.operation = static_cast<const BinaryExpression*>(exp)->operation;
+                ret.b = added.back();
+                added.pop_back();
+                ret.a = added.back();
+                added.pop_back();
+                break;
+
+            case ASTNodeKind::FunctionExpression:
+            {
+                auto range = item.arguments;
+                for (auto i = range.count; i-- > 0; ) {
+                    children[range.first + i] = added.back();
+                    added.pop_back();
+                }
+
+                ret.a = static_cast<const FunctionExpression*>(exp)->name.id;
+                ret.b = range.first;
+                ret.c = range.count;
+                break;
+            }
+
+            case ASTNodeKind::IntegerExpression:
+                ret.a = (Index)static_cast<const IntegerExpression*>(exp)->value;
+                break;
+
+            case ASTNodeKind::VariableExpression:
+                ret.a = static_cast<const VariableExpression*>(exp)->name.id;
+                break;
+
+            default:
+                break;
+            }
+
+            expressions.push_back(ret);
+            added.push_back((Index)expressions.size() - 1);
+        }
+
+        return added.back();
+    }
+
+    static std::string Indent(int indent, int tabWidth) {
+        return std::string(indent * tabWidth, ' ');
+    }
+
+    void PrintModule(std::stringstream& stream, Index index, int indent, int tabWidth) const
+    {
+        auto& mod = modules[index];
+        stream << Indent(indent, tabWidth) << "ModuleDefinition " << mod.id << std::endl;
+
+        for (Index i = 0; i < mod.variables.count; ++i)
+            PrintVariable(stream, child(mod.variables, i), indent + 1, tabWidth);
+
+        for (Index i = 0; i < mod.functions.count; ++i)
+            PrintFunction(stream, child(mod.functions, i), indent + 1, tabWidth);
+
+        for (Index i = 0; i < mod.modules.count; ++i)
+            PrintModule(stream, child(mod.modules, i), indent + 1, tabWidth);
+    }
+
+    void PrintVariable(std::stringstream& stream, Index index, int indent, int tabWidth) const
+    {
+        auto& var = variables[index];
+        stream << Indent(indent, tabWidth) << "VariableDeclaration " << var.typeName << " " << var.id << std::endl;
+
+        if (var.initializer != None)
+            PrintExpression(stream, var.initializer, indent + 1, tabWidth);
+    }
+
+    void PrintFunction(std::stringstream& stream, Index index, int indent, int tabWidth) const
+    {
+        auto& func = functions[index];
+        stream << Indent(indent, tabWidth) << "FunctionDefinition " << func.returnTypeName << " " << func.name << std::endl;
+
+        for (Index i = 0; i < func.params.count; ++i)
+        {
+            auto& param = params[child(func.params, i)];
+            stream << Indent(indent + 1, tabWidth) << "FunctionParameter " << param.typeName << " " << param.id << std::endl;
+        }
+
+        if (func.body != None)
+            PrintStatement(stream, func.body, indent + 1, tabWidth);
+    }
+
+    void PrintStatement(std::stringstream& stream, Index index, int indent, int tabWidth) const
+    {
+        auto& stmt = statements[index];
+
+        switch (stmt.kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            stream << Indent(indent, tabWidth) << "BlockStatement" << std::endl;
+
+            for (Index i = 0; i < stmt.statements().count; ++i)
+                PrintStatement(stream, child(stmt.statements(), i), indent + 1, tabWidth);
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+            stream << Indent(indent, tabWidth) << "DeclarationStatement" << std::endl;
+
+            if (stmt.variable() != None)
+                PrintVariable(stream, stmt.variable(), indent + 1, tabWidth);
+            break;
+
+        case ASTNodeKind::ExpressionStatement:
+        case ASTNodeKind::ReturnStatement:
+            stream << Indent(indent, tabWidth)
+                   << (stmt.kind == ASTNodeKind::ReturnStatement ? "ReturnStatement" : "ExpressionStatement") << std::endl;
+
+            if (stmt.expression() != None)
+                PrintExpression(stream, stmt.expression(), indent + 1, tabWidth);
+            break;
+
+        default:
+            stream << Indent(indent, tabWidth) << "Statement" << std::endl;
+            break;
+        }
+    }
+
+    // iterative, like Add(const Expression*)
+    void PrintExpression(std::stringstream& stream, Index root, int rootIndent, int tabWidth) const
+    {
+        // (expression, indent) pairs, next to print last
+        std::vector<std::pair<Index, int>> pending{ { root, rootIndent } };
+
+        while (!pending.empty())
+        {
+            auto index = pending.back().first;
+            auto indent = pending.back().second;
+            pending.pop_back();
+
+            auto& exp = expressions[index];
+
+            switch (exp.kind)
+            {
+            case ASTNodeKind::BinaryExpression:
+                stream << Indent(indent, tabWidth) << "BinaryExpression " << Lexer::GetTokenName(exp.operation) << std::endl;
+                pending.emplace_back(exp.right(), indent + 1);
+                pending.emplace_back(exp.left(), indent + 1);
+                break;
+
+            case ASTNodeKind::FunctionExpression:
+                stream << Indent(indent, tabWidth) << "FunctionExpression " << exp.name() << std::endl;
+
+                for (auto i = exp.arguments().count; i-- > 0; )
+                    pending.emplace_back(child(exp.arguments(), i), indent + 1);
+                break;
+
+            case ASTNodeKind::IntegerExpression:
+                stream << Indent(indent, tabWidth) << "IntegerExpression " << exp.value() << std::endl;
+                break;
+
+            case ASTNodeKind::VariableExpression:
+                stream << Indent(indent, tabWidth) << "VariableExpression " << exp.name() << std::endl;
+                break;
+
+            default:
+                stream << Indent(indent, tabWidth) << "Expression" << std::endl;
+                break;
+            }
+        }
+    }
+};
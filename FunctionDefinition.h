@@ -4,19 +4,84 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <string>
-#include <vector>
+#include <cstdint>
+#include "Symbol.h"
+#include "Arena.h"
 #include "FunctionParameter.h"
 #include "Statement.h"
 #include "ASTNode.h"
+#include "TypeTable.h"
+
+// A function body that was skipped while parsing, from its '{' at offset 'first' to its '}' at
+// offset 'last'. 'parser' parses it when it's first needed.
+struct LazyFunctionBody;
+
+class FunctionBodyParser
+{
+public:
+    virtual ~FunctionBodyParser() = default;
+    virtual Statement* ParseBody(const LazyFunctionBody& body) = 0;
+};
+
+struct LazyFunctionBody
+{
+    FunctionBodyParser* parser;
+    uint32_t first;
+    uint32_t last;
+};
 
 class FunctionDefinition : public ASTNode
 {
+    // the body is a cache of the skipped one, so it can be filled in through a const node
+    mutable Statement* body = nullptr;
+    mutable LazyFunctionBody* lazyBody = nullptr;
+
 public:
-    std::string returnTypeName;
-    std::string name;
-    std::vector<sptr<FunctionParameter>> params;
-    sptr<Statement> body;
+    Symbol returnTypeName;
+    Symbol name;
+    ArenaArray<FunctionParameter*> params;
+
+    // set by NameResolver: the index of the function in NameResolver::functions(), and the
+    // number of slots its parameters and local variables need
+    uint32_t index = Unresolved;
+    uint32_t frameSize = 0;
+
+    // the function's type, set by TypeChecker
+    TypeId type = TypeTable::Error;
+
+    FunctionDefinition()
+        : ASTNode(ASTNodeKind::FunctionDefinition) {}
+
+    // parses the body first if it was skipped, so syntax errors in it are thrown from here.
+    // parsing allocates from the translation unit's arena, which isn't thread safe.
+    Statement* GetBody() const
+    {
+        if (lazyBody) {
+            body = lazyBody->parser->ParseBody(*lazyBody);
+            lazyBody = nullptr;
+        }
+
+        return body;
+    }
+
+    void SetBody(Statement* statement) {
+        body = statement;
+        lazyBody = nullptr;
+    }
+
+    void SetLazyBody(LazyFunctionBody* lazy) {
+        body = nullptr;
+        lazyBody = lazy;
+    }
+
+    // false while the body is skipped and not parsed yet
+    bool bodyParsed() const {
+        return lazyBody == nullptr;
+    }
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
@@ -25,7 +90,7 @@ public:
         for (auto& p : params)
             p->Print(stream, indent + 1, tabWidth);
 
-        if(body)
+        if(GetBody())
             body->Print(stream, indent + 1, tabWidth);
     }
 };
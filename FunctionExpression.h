@@ -5,14 +5,24 @@
 
 #pragma once
 #include "Expression.h"
-#include <string>
-#include <vector>
+#include "Symbol.h"
+#include "Arena.h"
 
 class FunctionExpression : public Expression
 {
 public:
-    std::string name;
-    std::vector<sptr<Expression>> arguments;
+    Symbol name;
+    ArenaArray<Expression*> arguments;
+
+    // index of the called function in NameResolver::functions(), set by NameResolver
+    uint32_t function = Unresolved;
+
+    FunctionExpression()
+        : Expression(ASTNodeKind::FunctionExpression) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
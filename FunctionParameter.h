@@ -4,14 +4,29 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <string>
+#include "Symbol.h"
 #include "ASTNode.h"
+#include "TypeTable.h"
 
 class FunctionParameter : public ASTNode
 {
 public:
-    std::string typeName;
-    std::string id;
+    Symbol typeName;
+    Symbol id;
+
+    // where the parameter is stored, set by NameResolver. see VariableExpression.
+    uint32_t depth = Unresolved;
+    uint32_t slot = Unresolved;
+
+    // the declared type, set by TypeChecker
+    TypeId type = TypeTable::Error;
+
+    FunctionParameter()
+        : ASTNode(ASTNodeKind::FunctionParameter) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
@@ -9,6 +9,13 @@
 class ImportStatement : public ASTNode
 {
 public:
+    ImportStatement()
+        : ASTNode(ASTNodeKind::ImportStatement) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
+
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
         stream << MakeIndent(indent, tabWidth) << "ImportStatement" << std::endl;
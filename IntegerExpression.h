@@ -12,10 +12,14 @@ public:
     int value;
 
     IntegerExpression(int value = 0)
-        : value(value)
+        : Expression(ASTNodeKind::IntegerExpression), value(value)
     {
     }
 
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
+
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
         stream << MakeIndent(indent, tabWidth) << "IntegerExpression " << value <<  std::endl;
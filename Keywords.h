@@ -0,0 +1,133 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "TokenType.h"
+
+// Keyword recognition through a perfect hash that is generated and checked at compile time.
+// To add a keyword, add it to 'List'; compilation fails if no collision-free seed exists.
+namespace Keywords
+{
+    struct Keyword
+    {
+        std::string_view text;
+        TokenType type;
+        bool value;
+    };
+
+    inline constexpr Keyword List[] = {
+        { "module", TokenType::Module,  false },
+        { "return", TokenType::Return,  false },
+        { "true",   TokenType::Boolean, true },
+        { "false",  TokenType::Boolean, false },
+        { "null",   TokenType::Null,    false },
+    };
+
+    inline constexpr size_t Count = sizeof(List) / sizeof(List[0]);
+    inline constexpr size_t TableSize = 16;
+    static_assert((TableSize & (TableSize - 1)) == 0 && TableSize >= Count, "invalid keyword table size");
+
+    // only the length and the first and last characters are hashed
+    constexpr uint32_t Hash(const char* text, size_t length, uint32_t seed)
+    {
+        uint32_t h = (uint32_t)length * seed;
+        h = (h ^ (unsigned char)text[0]) * 0x9E3779B1u;
+        h = (h ^ (unsigned char)text[length - 1]) * seed;
+        return (h >> 16) & (TableSize - 1);
+    }
+
+    constexpr bool IsPerfect(uint32_t seed)
+    {
+        bool used[TableSize] = {};
+
+        for (auto& kw : List)
+        {
+            auto h = Hash(kw.text.data(), kw.text.size(), seed);
+            if (used[h])
+                return false;
+
+            used[h] = true;
+        }
+
+        return true;
+    }
+
+    constexpr uint32_t FindSeed()
+    {
+        for (uint32_t seed = 1; seed < 10000; ++seed)
+        {
+            if (IsPerfect(seed))
+                return seed;
+        }
+
+        return 0;
+    }
+
+    inline constexpr uint32_t Seed = FindSeed();
+    static_assert(Seed != 0, "no perfect hash seed found for the keyword list");
+
+    constexpr std::array<int8_t, TableSize> BuildTable()
+    {
+        std::array<int8_t, TableSize> table = {};
+
+        for (auto& slot : table)
+            slot = -1;
+
+        for (size_t i = 0; i < Count; ++i)
+            table[Hash(List[i].text.data(), List[i].text.size(), Seed)] = (int8_t)i;
+
+        return table;
+    }
+
+    constexpr size_t MinLength()
+    {
+        size_t ret = List[0].text.size();
+        for (auto& kw : List)
+            ret = kw.text.size() < ret ? kw.text.size() : ret;
+        return ret;
+    }
+
+    constexpr size_t MaxLength()
+    {
+        size_t ret = 0;
+        for (auto& kw : List)
+            ret = kw.text.size() > ret ? kw.text.size() : ret;
+        return ret;
+    }
+
+    inline constexpr std::array<int8_t, TableSize> Table = BuildTable();
+    inline constexpr size_t MinLen = MinLength();
+    inline constexpr size_t MaxLen = MaxLength();
+
+    // returns the keyword spelled by [text, text + length), or null for an ordinary identifier
+    constexpr const Keyword* Find(const char* text, size_t length)
+    {
+        if (length < MinLen || length > MaxLen)
+            return nullptr;
+
+        int index = Table[Hash(text, length, Seed)];
+        if (index < 0)
+            return nullptr;
+
+        auto& kw = List[index];
+        if (kw.text.size() != length)
+            return nullptr;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (kw.text[i] != text[i])
+                return nullptr;
+        }
+
+        return &kw;
+    }
+
+    static_assert(Find("module", 6) && Find("module", 6)->type == TokenType::Module, "keyword table is broken");
+    static_assert(!Find("modulo", 6), "keyword table is broken");
+}
@@ -5,176 +5,62 @@
 
 #pragma once
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <system_error>
 #include <cfloat>
 #include <memory>
-#include <fstream>
+#include <algorithm>
 #include <cassert>
 #include <vector>
-#include <variant>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
 #include <utf8.h>
+#include "Pointers.h"
+#include "SourceBuffer.h"
+#include "SourceStream.h"
+#include "Symbol.h"
+#include "TokenType.h"
+#include "Token.h"
+#include "TokenStream.h"
+#include "Keywords.h"
+#include "ScanKernels.h"
+#include "LexerTables.h"
+#include "SourceMap.h"
 using namespace std::string_literals;
 
-enum class TokenType
-{
-    Invalid = -1, // invalid 
-    EndOfFile,    // EOF
-    LeftCurly,    // {
-    RightCurly,   // }
-    LeftBracket,  // [
-    RightBracket, // ]
-    LeftParen,    // (
-    RightParen,   // )
-    Equals,       // =
-    Plus,         // +
-    Minus,        // -
-    Multiply,     // *
-    Divide,       // /
-    Dot,          // .
-    Comma,        // ,
-    Colon,        // :
-    Semicolon,    // ;
-    String,       // "abcd1234"
-    Integer,      // 123
-    Float,        // 12.34
-    Boolean,      // true false
-    Null,         // null
-    Identifier,   // _asdf3423
-};
-
-struct Token
-{
-    union ValueType {
-        int64_t intValue;
-        double floatValue;
-        bool boolValue;
-        char charValue;
-        std::string stringValue;
-
-        ValueType(){}
-        ~ValueType(){}
-    };
-
-    TokenType type = TokenType::EndOfFile;
-    size_t pos = -1;
-    ValueType storage;
-
-    Token() = default;
-
-    Token(const Token& tok) : type(tok.type), pos(tok.pos)
-    {
-        if (type == TokenType::String)
-            new (&storage.stringValue) std::string(tok.storage.stringValue);
-        else
-            memcpy(&storage, &tok.storage, sizeof(ValueType));
-    }
-
-    Token(Token&& tok) noexcept : type(tok.type), pos(tok.pos)
-    {
-        if (type == TokenType::String)
-            new (&storage.stringValue) std::string(std::move(tok.storage.stringValue));
-        else
-            memcpy(&storage, &tok.storage, sizeof(ValueType));
-    }
-
-    Token& operator=(const Token& tok)
-    {
-        if (type == TokenType::String) {
-            typedef std::string stype;
-            storage.stringValue.~stype();
-        }
-
-        type = tok.type;
-        pos = tok.pos;
-
-        if (type == TokenType::String)
-            new (&storage.stringValue) std::string(tok.storage.stringValue);
-        else
-            memcpy(&storage, &tok.storage, sizeof(ValueType));
-
-        return *this;
-    }
-
-    Token& operator=(Token&& tok) noexcept
-    {
-        if (type == TokenType::String) {
-            typedef std::string stype;
-            storage.stringValue.~stype();
-        }
-
-        type = tok.type;
-        pos = tok.pos;
-
-        if (type == TokenType::String)
-            new (&storage.stringValue) std::string(std::move(tok.storage.stringValue));
-        else
-            memcpy(&storage, &tok.storage, sizeof(ValueType));
-
-        return *this;
-    }
-
-    Token(TokenType type, size_t pos, const std::string& value)
-        : type(type), pos(pos)
-    {
-        new (&storage.stringValue) std::string(value);
-    }
-
-    Token(TokenType type, size_t pos, std::string&& value)
-        : type(type), pos(pos)
-    {
-        new (&storage.stringValue) std::string(std::move(value));
-    }
-
-    Token(TokenType type, size_t pos, int64_t value)
-        : type(type), pos(pos)
-    {
-        storage.intValue = value;
-    }
-
-    Token(TokenType type, size_t pos, double value)
-        : type(type), pos(pos)
-    {
-        storage.floatValue = value;
-    }
-
-    Token(TokenType type, size_t pos, bool value)
-        : type(type), pos(pos)
-    {
-        storage.boolValue = value;
-    }
-
-    Token(TokenType type, size_t pos, char value)
-        : type(type), pos(pos)
-    {
-        storage.charValue = value;
-    }
-
-    Token(TokenType type, size_t pos, std::nullptr_t value)
-        : type(type), pos(pos)
-    {
-        storage.intValue = 0;
-    }
-
-    ~Token()
-    {
-        if (type == TokenType::String) {
-            typedef std::string stype;
-            storage.stringValue.~stype();
-        }
-    }
-};
-
 class Lexer
 {
-    size_t line;
-    size_t column;
-    size_t offset;
-    char32_t value;
-    std::basic_string<int, std::char_traits<int>> chars;
-    int tabLength = 4;
+    sptr<SourceBuffer> source;
+    const char* start;
+    const char* cur;
+    const char* end;
+    const ScanKernels* scan = &ScanKernels::Get();
+
+    // Streaming mode: [start, end) is a window over 'input' instead of the whole source.
+    // 'base' is the offset of the window in the input, and 'windowLocation' its line and column.
+    sptr<SourceStream> input;
+    std::unique_ptr<char[]> window;
+    size_t windowSize = 0;
+    size_t base = 0;
+    size_t retained = 0;
+    SourceLocation windowLocation{ 1, 1 };
+
+    // thrown when a scan reaches the end of the window before the end of the input
+    struct WindowUnderflow {};
+
+    // Parallel lexing: chunks after the first may start inside a string literal, so errors
+    // only stop the chunk, and are reported when the sequential fix-up pass gets to them.
+    bool speculative = false;
+    struct SpeculationFailed {};
+
+    // bytes kept ahead of each token, enough for any operator or number prefix
+    static constexpr ptrdiff_t MinLookahead = 64;
 
 public:
 
@@ -203,72 +89,162 @@ public:
             { (int)TokenType::Float, "float" },
             { (int)TokenType::Boolean, "boolean" },
             { (int)TokenType::Null, "null" },
-            { (int)TokenType::Identifier, "identifier" }
+            { (int)TokenType::Identifier, "identifier" },
+            { (int)TokenType::Module, "module" },
+            { (int)TokenType::Return, "return" }
         };
         
         return tokenNames.at((int)type);
     }
 
     bool endOfFile() const {
-        return offset == chars.size();
+        return cur == end && (!input || input->done());
     }
 
     char32_t getValue() const {
-        return value;
+        if (cur == end)
+            return 0;
+
+        if (IsAscii(*cur))
+            return (char32_t)*cur;
+
+        auto it = cur;
+        return DecodeChar(it);
     }
 
     size_t getOffset() const {
-        return offset;
+        return base + (cur - start);
     }
 
+    // length of the source, or of the current window when streaming
     size_t contentLength() const {
-        return chars.size();
+        return end - start;
     }
 
     Lexer(const std::string& filename)
+        : Lexer(SourceBuffer::FromFile(filename))
+    {
+    }
+
+    Lexer(const sptr<SourceBuffer>& source)
+        : source(source)
     {
-        std::ifstream fin(filename, std::ios::in | std::ios::binary);
+        if (source->empty())
+            throw std::runtime_error("file is empty: "s + source->filename());
+
+        // token text is addressed with 32 bit offsets
+        if (source->size() > UINT32_MAX)
+            throw std::runtime_error("file is too large: "s + source->filename());
 
-        if (!fin.good())
-            throw std::runtime_error("failed to open file: "s + filename);
+        start = source->data();
+        cur = start;
+        end = start + source->size();
+    }
 
-        fin.seekg(0, std::ios::end);
-        auto sz = (size_t)fin.tellg();
-        fin.seekg(0, std::ios::beg);
+    // lexes only [from, to) of 'source'. positions are still offsets into the whole source.
+    Lexer(const sptr<SourceBuffer>& source, size_t from, size_t to)
+        : Lexer(source)
+    {
+        assert(from <= to && to <= source->size());
+        base = from;
+        start = source->data() + from;
+        cur = start;
+        end = source->data() + to;
+    }
 
-        if (sz == 0)
-            throw std::runtime_error("file is empty: "s + filename);
+    // Streaming: reads 'input' through a window of 'windowSize' bytes instead of holding all of it in memory.
+    // The window only grows for a single token that doesn't fit in it. getSource() is null in this mode,
+    // and the text of a string token can only be retrieved while it's retained (see Retain).
+    Lexer(const sptr<SourceStream>& input, size_t windowSize = 64 * 1024)
+        : input(input), windowSize(std::max(windowSize, (size_t)MinLookahead * 2))
+    {
+        window.reset(new char[this->windowSize]);
+        start = cur = end = window.get();
+        Refill(cur);
 
-        auto buffer = std::unique_ptr<char[]>(new char[sz]);
-        fin.read(buffer.get(), sz);
+        if (cur == end)
+            throw std::runtime_error("file is empty: "s + input->filename());
+    }
 
-        utf8::utf8to32(buffer.get(), buffer.get() + sz, std::back_inserter(chars));
+    const sptr<SourceBuffer>& getSource() const {
+        return source;
+    }
 
-        line = 0;
-        column = 0;
-        offset = 0;
-        value = chars[0];
+    // Streaming: keeps the input from 'offset' on in the window when it's refilled, so GetText and
+    // Describe still work for tokens from there on. By default only the last token is kept.
+    void Retain(size_t offset) {
+        retained = offset;
     }
 
-    static std::vector<Token> Tokenize(const std::string& filename)
+    // "file:line:column" of an offset in the source. when streaming, the offset must be retained.
+    std::string Describe(size_t offset) const
     {
-        std::vector<Token> tokens;
-        Lexer lexer(filename);
+        if (!input)
+            return SourceMap(source).Describe(offset);
 
-        do {
-            tokens.push_back(lexer.GetNextToken());
-        } while (!lexer.endOfFile());
+        assert(offset >= base && offset - base <= (size_t)(end - start));
+        auto loc = SourceMap::Advance(windowLocation, start, start + (offset - base));
+        return SourceMap::Describe(input->filename(), loc);
+    }
 
-        return tokens;
+    // raw text of an identifier or string literal token, without quotes or escape processing
+    static std::string_view GetText(const SourceBuffer& source, const Token& token)
+    {
+        if (token.type == TokenType::Identifier)
+            return token.storage.symbol.str();
+
+        assert(token.type == TokenType::String);
+        assert((size_t)token.storage.text.offset + token.storage.text.length <= source.size());
+        return std::string_view(source.data() + token.storage.text.offset, token.storage.text.length);
+    }
+
+    std::string_view GetText(const Token& token) const
+    {
+        if (token.type == TokenType::Identifier)
+            return token.storage.symbol.str();
+
+        if (!input)
+            return GetText(*source, token);
+
+        // offsets wrap past 4 GB, but the window is smaller than that, so the distance from 'base' is exact
+        assert(token.type == TokenType::String);
+        auto offset = (uint32_t)(token.storage.text.offset - (uint32_t)base);
+        assert((size_t)offset + token.storage.text.length <= (size_t)(end - start));
+        return std::string_view(start + offset, token.storage.text.length);
+    }
+
+    // value of a string literal token, decoding escape sequences if there are any
+    static std::string GetString(const SourceBuffer& source, const Token& token)
+    {
+        assert(token.type == TokenType::String);
+        auto text = GetText(source, token);
+        return token.escaped ? DecodeString(text) : std::string(text);
     }
 
+    std::string GetString(const Token& token) const
+    {
+        assert(token.type == TokenType::String);
+        auto text = GetText(token);
+        return token.escaped ? DecodeString(text) : std::string(text);
+    }
+
+    static std::vector<Token> Tokenize(const std::string& filename)
+    {
+        Lexer lexer(filename);
+        return lexer.Tokenize();
+    }
+
+    // appends all tokens, up to and including the end of file token
     void Tokenize(std::vector<Token>& outTokens)
     {
-        assert(offset == 0);
+        assert(cur == start);
+
+        Token token;
 
         do {
-            outTokens.push_back(GetNextToken());
-        } while (!endOfFile());
+            token = GetNextToken();
+            outTokens.push_back(token);
+        } while (token.type != TokenType::EndOfFile);
     }
 
     std::vector<Token> Tokenize()
@@ -278,386 +254,692 @@ public:
         return tokens;
     }
 
-    Token GetNextToken()
+    // appends all tokens, up to and including the end of file token
+    void Tokenize(TokenStream& outTokens)
     {
-        SkipWhitespace();
+        assert(cur == start);
+        assert(source && outTokens.getSource() == source);
 
-        auto pos = offset;
+        outTokens.ReserveForSource(contentLength());
 
-        if (offset == chars.size())
-            return Token(TokenType::EndOfFile, pos, (char)EOF);
-        
-        switch (value)
+        Token token;
+
+        do {
+            token = GetNextToken();
+            outTokens.Append(token);
+        } while (token.type != TokenType::EndOfFile);
+    }
+
+    static TokenStream TokenizeStream(const sptr<SourceBuffer>& source)
+    {
+        TokenStream tokens(source);
+        Lexer lexer(source);
+        lexer.Tokenize(tokens);
+        return tokens;
+    }
+
+    // Same tokens as TokenizeStream, lexed by up to 'threadCount' threads.
+    // The source is split at newlines and each chunk is lexed on the assumption that it doesn't
+    // start inside a string literal, the only kind of token that can span a newline. The chunks
+    // are then joined in order: where the previous chunk ended inside a token, lexing continues
+    // sequentially from there until a token starts at the same offset as one in the next chunk,
+    // after which the lexer is in the same state the speculative one was, and the rest is reused.
+    static TokenStream TokenizeParallel(const sptr<SourceBuffer>& source, size_t threadCount = std::thread::hardware_concurrency())
+    {
+        const size_t MinChunkSize = 256 * 1024;
+
+        size_t size = source->size();
+        threadCount = std::min(threadCount, size / MinChunkSize);
+
+        if (threadCount <= 1)
+            return TokenizeStream(source);
+
+        struct Chunk
         {
-        case '{':
-            SkipChar();
-            return Token(TokenType::LeftCurly, pos, '{');
-        case '}':
-            SkipChar();
-            return Token(TokenType::RightCurly, pos, '}');
-        case '[':
-            SkipChar();
-            return Token(TokenType::LeftBracket, pos, '[');
-        case ']':
-            SkipChar();
-            return Token(TokenType::RightBracket, pos, ']');
-        case '(':
-            SkipChar();
-            return Token(TokenType::LeftParen, pos, '(');
-        case ')':
-            SkipChar();
-            return Token(TokenType::RightParen, pos, ')');
-        case '=':
-            SkipChar();
-            return Token(TokenType::Equals, pos, '=');
-        case '+':
-            SkipChar();
-            return Token(TokenType::Plus, pos, '+');
-        case '-':
-            SkipChar();
-            return Token(TokenType::Minus, pos, '-');
-        case '*':
-            SkipChar();
-            return Token(TokenType::Multiply, pos, '*');
-        case '/':
-            SkipChar();
-            return Token(TokenType::Divide, pos, '/');
-        case ',':
-            SkipChar();
-            return Token(TokenType::Comma, pos, ',');
-        case ':':
-            SkipChar();
-            return Token(TokenType::Colon, pos, ':');
-        case ';':
-            SkipChar();
-            return Token(TokenType::Semicolon, pos, ',');
-        case '\"':
-            return GetStringToken();
-        case '.':
-            if(!isdigit(chars[offset + 1])) {
-                SkipChar();
-                return Token(TokenType::Dot, pos, ',');
+            size_t from;
+            size_t to;
+            size_t stop; // end of the last token lexed, or 'to' if the whole chunk was
+            TokenStream tokens;
+        };
+
+        std::vector<Chunk> chunks;
+        auto data = source->data();
+
+        for (size_t i = 0, from = 0; i < threadCount && from < size; ++i)
+        {
+            size_t to = size;
+
+            if (i + 1 < threadCount)
+            {
+                auto target = std::max(from, size / threadCount * (i + 1));
+                auto newline = (const char*)memchr(data + target, '\n', size - target);
+                to = newline ? newline - data + 1 : size;
             }
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            return GetNumberToken();
-        case 'a':
-        case 'b':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-        case 'g':
-        case 'h':
-        case 'i':
-        case 'j':
-        case 'k':
-        case 'l':
-        case 'm':
-        case 'n':
-        case 'o':
-        case 'p':
-        case 'q':
-        case 'r':
-        case 's':
-        case 't':
-        case 'u':
-        case 'v':
-        case 'w':
-        case 'x':
-        case 'y':
-        case 'z':
-        case 'A':
-        case 'B':
-        case 'C':
-        case 'D':
-        case 'E':
-        case 'F':
-        case 'G':
-        case 'H':
-        case 'I':
-        case 'J':
-        case 'K':
-        case 'L':
-        case 'M':
-        case 'N':
-        case 'O':
-        case 'P':
-        case 'Q':
-        case 'R':
-        case 'S':
-        case 'T':
-        case 'U':
-        case 'V':
-        case 'W':
-        case 'X':
-        case 'Y':
-        case 'Z':
-        case '_':
-            return GetIdentifierToken();
-        default:
-            throw std::runtime_error("found unexpected input: "s + (char)value);
+
+            chunks.push_back(Chunk{ from, to, from, TokenStream(source) });
+            from = to;
         }
-    }
 
-private:
-    
-    void SkipWhitespace()
-    {
-        while (offset != chars.size())
+        auto lexChunk = [&source](Chunk& chunk)
         {
-            if (value == ' ') // spaces
+            Lexer lexer(source, chunk.from, chunk.to);
+            lexer.speculative = true;
+            chunk.tokens.ReserveForSource(chunk.to - chunk.from);
+
+            try {
+                for (;;)
+                {
+                    auto token = lexer.ScanToken();
+
+                    if (token.type == TokenType::EndOfFile) {
+                        chunk.stop = chunk.to;
+                        break;
+                    }
+
+                    chunk.tokens.Append(token);
+                    chunk.stop = lexer.getOffset();
+                }
+            }
+            catch (const SpeculationFailed&) {
+            }
+        };
+
+        std::vector<std::thread> threads;
+
+        for (size_t i = 1; i < chunks.size(); ++i)
+            threads.emplace_back(lexChunk, std::ref(chunks[i]));
+
+        lexChunk(chunks[0]);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        TokenStream tokens(source);
+        tokens.ReserveForSource(size);
+
+        // where sequential lexing would continue
+        size_t pos = 0;
+
+        for (auto& chunk : chunks)
+        {
+            if (pos == chunk.from)
             {
-                ++column;
+                tokens.Append(chunk.tokens);
+                pos = chunk.stop;
+                continue;
             }
-            else if (value == '\t')
+
+            if (pos >= chunk.to)
+                continue;
+
+            Lexer lexer(source, pos, size);
+            size_t next = 0;
+
+            for (;;)
             {
-                column += tabLength;
+                auto token = lexer.ScanToken();
+
+                if (token.type == TokenType::EndOfFile || token.pos >= chunk.to) {
+                    pos = token.pos;
+                    break;
+                }
+
+                while (next < chunk.tokens.size() && chunk.tokens.position(next) < token.pos)
+                    ++next;
+
+                if (next < chunk.tokens.size() && chunk.tokens.position(next) == token.pos) {
+                    tokens.Append(chunk.tokens, next);
+                    pos = chunk.stop;
+                    break;
+                }
+
+                tokens.Append(token);
             }
-            else if (value == '\n') // new line
+        }
+
+        // the rest, if the last chunk stopped early. errors are reported from here.
+        Lexer lexer(source, pos, size);
+        lexer.Tokenize(tokens);
+        return tokens;
+    }
+
+    Token GetNextToken()
+    {
+        if (input)
+            return GetNextStreamToken();
+
+        return ScanToken();
+    }
+
+    // Skips to the '}' that closes a block whose '{' was the last token, and returns that '}', or the
+    // end of file token if the block isn't closed. The input in between isn't tokenized, only searched
+    // for braces outside of string literals, so it isn't checked either. In-memory sources only.
+    Token SkipBlock()
+    {
+        assert(!input);
+        size_t depth = 1;
+
+        while (cur != end)
+        {
+            char c = *cur++;
+
+            if (c == '{')
             {
-                ++line;
-                column = 0;
+                ++depth;
             }
-            else if (value == '\v' || value == '\f' || value == '\r')
+            else if (c == '}')
             {
-                // ignore
+                if (--depth == 0)
+                    return Token(TokenType::RightCurly, getOffset() - 1, '}');
             }
-            else
+            else if (c == '\"')
             {
-                // found non-whitespace character
-                break;
+                for (; cur != end && *cur != '\"'; ++cur)
+                {
+                    if (*cur == '\\' && cur + 1 != end)
+                        ++cur;
+                }
+
+                if (cur != end)
+                    ++cur;
             }
+        }
 
-            SkipChar();
+        return Token(TokenType::EndOfFile, getOffset(), (char)EOF);
+    }
+
+private:
+
+    Token ScanToken()
+    {
+        SkipWhitespace();
+
+        auto pos = getOffset();
+
+        if (cur == end)
+            return Token(TokenType::EndOfFile, pos, (char)EOF);
+
+        switch (LexerTables::CharClasses[(unsigned char)*cur])
+        {
+        case LexerTables::CharClass::Operator:
+            return GetOperatorToken();
+        case LexerTables::CharClass::Identifier:
+        case LexerTables::CharClass::NonAscii:
+            return GetIdentifierToken();
+        case LexerTables::CharClass::Number:
+            return GetNumberToken();
+        case LexerTables::CharClass::String:
+            return GetStringToken();
+        case LexerTables::CharClass::DotOrNumber:
+            if (LexerTables::IsDigit(PeekNextChar()))
+                return GetNumberToken();
+            return GetOperatorToken();
+        default:
+            Error(getOffset(), "found unexpected input: "s + *cur);
         }
     }
 
-    char32_t PeekNextChar() {
-        assert(offset < chars.size());
-        return chars[offset + 1];
+    // Tokens are scanned as usual, and scanned again after a refill if the scan ran into the
+    // end of the window, so tokens and UTF-8 sequences that straddle chunks come out whole.
+    Token GetNextStreamToken()
+    {
+        for (;;)
+        {
+            SkipWhitespace();
+
+            if (end - cur < MinLookahead && Refill(cur))
+                continue;
+
+            auto tokenStart = cur;
+
+            try {
+                auto token = ScanToken();
+                CheckWindowEnd(cur);
+                return token;
+            }
+            catch (const WindowUnderflow&) {
+                cur = tokenStart;
+                Refill(tokenStart);
+            }
+        }
     }
 
-    void SkipChar() {
-        assert(offset <= chars.size());
-        value = chars[++offset];
+    // Discards the window up to 'keep' and fills the rest from the input.
+    // The window doubles if 'keep' is at its start and it's already full.
+    bool Refill(const char* keep)
+    {
+        if (!input || input->done())
+            return false;
+
+        assert(start <= keep && keep <= cur && cur <= end);
+
+        if (retained >= base && retained < base + (keep - start))
+            keep = start + (retained - base);
+
+        windowLocation = SourceMap::Advance(windowLocation, start, keep);
+        base += keep - start;
+
+        size_t kept = end - keep;
+        size_t curOffset = cur - keep;
+
+        if (kept == windowSize)
+        {
+            std::unique_ptr<char[]> grown(new char[windowSize * 2]);
+            memcpy(grown.get(), keep, kept);
+            window = std::move(grown);
+            windowSize *= 2;
+        }
+        else if (kept != 0)
+        {
+            memmove(window.get(), keep, kept);
+        }
+
+        while (kept < windowSize)
+        {
+            size_t n = input->Read(window.get() + kept, windowSize - kept);
+            if (n == 0)
+                break;
+
+            kept += n;
+        }
+
+        start = window.get();
+        cur = start + curOffset;
+        end = start + kept;
+        return true;
     }
 
-    void SkipChars(int count) {
-        assert(offset <= chars.size() - count);
-        value = chars[offset += count];
+    // a scan that stopped at 'p' may have stopped early if more input is coming
+    void CheckWindowEnd(const char* p) const
+    {
+        if (p == end && input && !input->done())
+            throw WindowUnderflow();
     }
 
-    bool IsStartOfNumber(char32_t c) {
-        return (c >= '0' && c <= '9') || c == '-' || c == '+';
+    // diagnostics are rare, so the line/column lookup is only done here
+    [[noreturn]] void Error(size_t offset, const std::string& message) const
+    {
+        if (speculative)
+            throw SpeculationFailed();
+
+        // errors at the end of the window may just be a token that's cut off.
+        // the largest look-behind of any check is a 4 byte UTF-8 sequence or \u escape.
+        if (input && end - cur < 8 && !input->done())
+            throw WindowUnderflow();
+
+        throw std::runtime_error(Describe(offset) + ": " + message);
+    }
+    
+    static bool IsAscii(char c) {
+        return (unsigned char)c < 0x80;
     }
 
-    bool IsStartOf(char32_t c) {
-        return (c >= '0' && c <= '9') || c == '-' || c == '+';
+    // decodes the UTF-8 sequence at 'it' and advances past it
+    char32_t DecodeChar(const char*& it) const
+    {
+        try {
+            return (char32_t)utf8::next(it, end);
+        }
+        catch (const utf8::exception&) {
+            Error(base + (it - start), "invalid UTF-8 sequence");
+        }
+    }
+
+    void SkipWhitespace() {
+        cur = scan->SkipWhitespace(cur, end);
+    }
+
+    char PeekNextChar() {
+        assert(cur < end);
+        return cur + 1 < end ? cur[1] : '\0';
+    }
+
+    // advances past the current character, which must be ASCII
+    void SkipChar() {
+        assert(cur < end && IsAscii(*cur));
+        ++cur;
+    }
+
+    // longest operator match, found by walking the operator DFA
+    Token GetOperatorToken()
+    {
+        auto& dfa = LexerTables::Operator;
+
+        auto pos = getOffset();
+        auto p = cur;
+        auto matchEnd = cur;
+        auto type = TokenType::Invalid;
+        size_t state = 0;
+
+        while (p != end && (state = dfa.next[state][(unsigned char)*p]) != 0)
+        {
+            ++p;
+
+            if (dfa.accept[state] != TokenType::Invalid) {
+                type = dfa.accept[state];
+                matchEnd = p;
+            }
+
+            if (dfa.leaf[state])
+                break;
+        }
+
+        if (type == TokenType::Invalid)
+            Error(getOffset(), "found unexpected input: "s + *cur);
+
+        char value = *cur;
+        cur = matchEnd;
+        return Token(type, pos, value);
     }
 
     Token GetStringToken()
     {
-        assert(value == '\"');
+        assert(*cur == '\"');
         
-        auto start = offset;
+        auto pos = getOffset();
         SkipChar();
 
-        std::u32string str;
-        
-        while (offset != chars.size())
+        auto contentStart = cur;
+        bool escaped = false;
+
+        // find the closing quote, validating escapes and multi-byte sequences on the way.
+        // the contents are only decoded if someone asks for the string's value.
+        while ((cur = scan->SkipStringBody(cur, end)) != end)
         {
-            if (value == '\"')
+            if (*cur == '\"')
             {
+                Token::TextRange text{ (uint32_t)(base + (contentStart - start)), (uint32_t)(cur - contentStart) };
                 SkipChar();
-
-                std::string utf8str;
-                utf8str.reserve(str.size());
-                utf8::utf32to8(str.begin(), str.end(), std::back_inserter(utf8str));
-                return Token(TokenType::String, start, utf8str);
+                return Token(TokenType::String, pos, text, escaped);
             }
-            else if (value == '\\')
+            else if (*cur == '\\')
             {
+                escaped = true;
                 SkipChar();
 
-                if (offset == chars.size())
-                    throw std::runtime_error("unexpected end of input");
+                if (cur == end)
+                    Error(getOffset(), "unexpected end of input");
 
-                if (value == '\"') {
-                    SkipChar();
-                    str += '\"';
-                }
-                else if (value == '\\') {
-                    SkipChar();
-                    str += '\\';
-                }
-                else if (value == '/') {
-                    SkipChar();
-                    str += '/';
-                }
-                else if (value == 'b') {
-                    SkipChar();
-                    str += '\b';
-                }
-                else if (value == 'f') {
-                    SkipChar();
-                    str += '\f';
-                }
-                else if (value == 'n') {
-                    SkipChar();
-                    str += '\n';
-                }
-                else if (value == 'r') {
-                    SkipChar();
-                    str += '\r';
-                }
-                else if (value == 't') {
-                    SkipChar();
-                    str += '\t';
-                }
-                else if (value == 'u')
+                if (*cur == 'u')
                 {
+                    size_t escapePos = getOffset() - 1;
                     SkipChar();
 
-                    if (offset > chars.size() - 4)
-                        throw std::runtime_error("unexpected end of input");
+                    // code points above U+FFFF are written as a UTF-16 surrogate pair: \uD83D\uDE00
+                    char32_t unit = ScanHex4();
 
-                    char hex[4];
+                    if (IsLowSurrogate(unit))
+                        Error(escapePos, "unpaired surrogate in unicode escape sequence");
 
-                    for (int i = 0; i < 4; ++i)
+                    if (IsHighSurrogate(unit))
                     {
-                        if (!isxdigit(value))
-                            throw std::runtime_error("invalid unicode escape sequence");
+                        if (end - cur < 2 || cur[0] != '\\' || cur[1] != 'u')
+                            Error(escapePos, "unpaired surrogate in unicode escape sequence");
 
-                        hex[i] = (char)value;
                         SkipChar();
+                        SkipChar();
+
+                        if (!IsLowSurrogate(ScanHex4()))
+                            Error(escapePos, "unpaired surrogate in unicode escape sequence");
                     }
-                    
-                    str += (char32_t)std::strtoul(hex, nullptr, 16);
                 }
-                else
+                else if (IsAscii(*cur))
                 {
-                    str += value;
                     SkipChar();
                 }
+                else
+                {
+                    DecodeChar(cur);
+                }
             }
             else
             {
-                str += value;
-                SkipChar();
+                DecodeChar(cur);
             }
         }
 
-        assert(offset == chars.size());
-        throw std::runtime_error("unexpected end of input");
+        assert(cur == end);
+        Error(getOffset(), "unexpected end of input");
     }
 
-    Token GetNumberToken()
+    // the 4 hex digits of a \u escape
+    char32_t ScanHex4()
     {
-        size_t numberStart = offset;
-        
-        //int sign = 1;
-
-        //if (value == '-') {
-        //    sign = -1;
-        //    SkipChar();
-        //}
-        //else if (value == '+') {
-        //    SkipChar();
-        //}
-
-        // MANTISSA
-        size_t mantStart = offset;
-        int64_t mantissa = 0;
-        int64_t exponent = 0;
-        bool hasDecimal = false;
-        
-        while (offset < chars.size())
+        char32_t value = 0;
+
+        for (int i = 0; i < 4; ++i)
         {
-            if (isdigit(value)) {
+            if (cur == end)
+                Error(getOffset(), "unexpected end of input");
 
-                if (hasDecimal)
-                    --exponent;
+            int digit = LexerTables::HexValue(*cur);
+            if (digit < 0)
+                Error(getOffset(), "invalid unicode escape sequence");
 
-                mantissa = mantissa * 10 + (value - U'0');
-                SkipChar();
-            }
-            else if (value == '.' && !hasDecimal) {
-                hasDecimal = true;
-                SkipChar();
-                continue;
-            }
-            else {
+            value = (value << 4) | (char32_t)digit;
+            SkipChar();
+        }
+
+        return value;
+    }
+
+    static bool IsHighSurrogate(char32_t c) {
+        return c >= 0xD800 && c <= 0xDBFF;
+    }
+
+    static bool IsLowSurrogate(char32_t c) {
+        return c >= 0xDC00 && c <= 0xDFFF;
+    }
+
+    // decodes 4 hex digits that are known to be valid, and advances past them
+    static char32_t DecodeHex4(const char*& it)
+    {
+        char32_t value = 0;
+
+        for (int i = 0; i < 4; ++i)
+            value = (value << 4) | (char32_t)LexerTables::HexValue(*it++);
+
+        return value;
+    }
+
+    // decodes the escape sequences in the body of a string literal that was validated by GetStringToken
+    static std::string DecodeString(std::string_view text)
+    {
+        std::string str;
+        str.reserve(text.size());
+
+        auto it = text.data();
+        auto end = text.data() + text.size();
+
+        while (it != end)
+        {
+            // copy everything up to the next escape at once
+            auto slash = (const char*)memchr(it, '\\', end - it);
+            if (!slash)
+                slash = end;
+
+            str.append(it, slash);
+            it = slash;
+
+            if (it == end)
                 break;
+
+            ++it;
+            assert(it != end);
+
+            char c = *it++;
+
+            if (c == 'b')
+                str += '\b';
+            else if (c == 'f')
+                str += '\f';
+            else if (c == 'n')
+                str += '\n';
+            else if (c == 'r')
+                str += '\r';
+            else if (c == 't')
+                str += '\t';
+            else if (c == 'u')
+            {
+                auto cp = DecodeHex4(it);
+
+                // GetStringToken made sure a low surrogate escape follows
+                if (IsHighSurrogate(cp))
+                {
+                    it += 2;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (DecodeHex4(it) - 0xDC00);
+                }
+
+                utf8::append(cp, std::back_inserter(str));
+            }
+            else
+            {
+                // '"', '\\', '/' and anything unrecognized stand for themselves
+                str += c;
             }
         }
 
-        //if (offset - mantStart == 0)
-        //    throw runtime_error("invalid number (no whole part)");
+        return str;
+    }
 
-        if (value == 'e' || value == 'E')
+    // Numbers are integers if they have no fractional digits left after applying the exponent
+    // (e.g. 12, 12e3 and 1.5e1), and floats otherwise. Integers are accumulated with overflow
+    // checks. Floats are converted by std::from_chars, which is correctly rounded.
+    Token GetNumberToken()
+    {
+        size_t numberStart = getOffset();
+        auto first = cur;
+
+        // fast path: plain decimal integers
+        int64_t value = 0;
+
+        while (cur != end && LexerTables::IsDigit(*cur))
+        {
+            if (!AccumulateDigit(value, *cur))
+                Error(numberStart, "integer literal is too large");
+
+            SkipChar();
+        }
+
+        if (cur == end || (*cur != '.' && *cur != 'e' && *cur != 'E'))
+            return Token(TokenType::Integer, numberStart, value);
+
+        // fraction
+        int64_t fractionDigits = 0;
+        auto fractionStart = cur;
+
+        if (*cur == '.')
+        {
+            SkipChar();
+            fractionStart = cur;
+
+            while (cur != end && LexerTables::IsDigit(*cur))
+                SkipChar();
+
+            fractionDigits = cur - fractionStart;
+        }
+
+        // exponent
+        int64_t exponent = 0;
+
+        if (cur != end && (*cur == 'e' || *cur == 'E'))
         {
             SkipChar();
 
             int expSign = 1;
 
-            if (value == '-') {
+            if (cur != end && *cur == '-') {
                 expSign = -1;
                 SkipChar();
             }
-            else if (value == '+') {
+            else if (cur != end && *cur == '+') {
                 SkipChar();
             }
 
-            int64_t exp = 0;
+            if (cur == end || !LexerTables::IsDigit(*cur))
+                Error(numberStart, "exponent has no digits");
+
+            while (cur != end && LexerTables::IsDigit(*cur))
+            {
+                // saturate; anything this large is out of range either way
+                if (exponent < 100000)
+                    exponent = exponent * 10 + (*cur - '0');
 
-            while (offset < chars.size() && isdigit(value)) {
-                exp = exp * 10 + (value - U'0');
                 SkipChar();
             }
 
-            exponent += exp * expSign;
-
-            // exponent is required if 'e' or 'E' are present
-            //if (expStart == expEnd)
-            //    throw runtime_error("invalid number");
+            exponent *= expSign;
         }
 
-        if (exponent >= 0) {
-            //auto wholeNumber = mantissa * (int64_t)(std::pow(10, exponent) + 0.5) * sign;
-            auto wholeNumber = mantissa * (int64_t)(std::pow(10, exponent) + 0.5);
-            return Token(TokenType::Integer, numberStart, wholeNumber);
+        if (exponent - fractionDigits >= 0)
+        {
+            // integer: whole digits, then fraction digits, then the remaining power of ten
+            for (auto p = fractionStart; p != fractionStart + fractionDigits; ++p)
+            {
+                if (!AccumulateDigit(value, *p))
+                    Error(numberStart, "integer literal is too large");
+            }
+
+            for (int64_t i = fractionDigits; i < exponent; ++i)
+            {
+                if (!AccumulateDigit(value, '0'))
+                    Error(numberStart, "integer literal is too large");
+            }
+
+            return Token(TokenType::Integer, numberStart, value);
         }
 
-        //auto fractNumber = (double)std::copysign(mantissa * std::pow(10.0L, exponent), sign);
-        auto fractNumber = (double)(mantissa * std::pow(10.0L, exponent));
+        double fractNumber = 0;
+        auto result = std::from_chars(first, cur, fractNumber);
+
+        if (result.ec == std::errc::result_out_of_range)
+            Error(numberStart, "floating point literal is out of range");
+
+        assert(result.ec == std::errc() && result.ptr == cur);
         return Token(TokenType::Float, numberStart, fractNumber);
     }
 
+    // value = value * 10 + digit, returning false on overflow
+    static bool AccumulateDigit(int64_t& value, char digit)
+    {
+        int64_t d = digit - '0';
+
+        if (value > (INT64_MAX - d) / 10)
+            return false;
+
+        value = value * 10 + d;
+        return true;
+    }
+
     Token GetIdentifierToken()
     {
-        assert(isalpha(value) || value == '_');
+        auto pos = getOffset();
+        auto idStart = cur;
 
-        size_t start = offset;
-        std::u32string str;
+        for (;;)
+        {
+            cur = scan->SkipIdentifier(cur, end);
 
-        do {
-            str.push_back(value);
-            SkipChar();
-        } while (offset != chars.size() && (isalnum(value) || value == '_'));
+            if (cur == end || IsAscii(*cur))
+                break;
+
+            DecodeChar(cur);
+        }
 
-        std::string utf8str;
-        utf8str.reserve(str.size());
-        utf8::utf32to8(str.begin(), str.end(), std::back_inserter(utf8str));
+        assert(cur != idStart);
+
+        // before the name is interned, so cut off names don't end up in the symbol table
+        CheckWindowEnd(cur);
+
+        if (auto kw = Keywords::Find(idStart, cur - idStart))
+        {
+            if (kw->type == TokenType::Boolean)
+                return Token(TokenType::Boolean, pos, kw->value);
+
+            return Token(kw->type, pos, nullptr);
+        }
 
-        return Token(TokenType::Identifier, start, utf8str);
+        auto symbol = Symbol::Intern(std::string_view(idStart, cur - idStart));
+        return Token(TokenType::Identifier, pos, symbol);
     }
 };
@@ -0,0 +1,185 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "TokenType.h"
+
+// Declarative token spec for the lexer, and the tables generated from it at compile time.
+// Adding an operator, including a multi-character one, only takes a new entry in 'Operators'.
+namespace LexerTables
+{
+    struct OperatorSpec
+    {
+        std::string_view text;
+        TokenType type;
+    };
+
+    inline constexpr OperatorSpec Operators[] = {
+        { "{", TokenType::LeftCurly },
+        { "}", TokenType::RightCurly },
+        { "[", TokenType::LeftBracket },
+        { "]", TokenType::RightBracket },
+        { "(", TokenType::LeftParen },
+        { ")", TokenType::RightParen },
+        { "=", TokenType::Equals },
+        { "+", TokenType::Plus },
+        { "-", TokenType::Minus },
+        { "*", TokenType::Multiply },
+        { "/", TokenType::Divide },
+        { ".", TokenType::Dot },
+        { ",", TokenType::Comma },
+        { ":", TokenType::Colon },
+        { ";", TokenType::Semicolon },
+    };
+
+    inline constexpr std::string_view WhitespaceChars = " \t\n\v\f\r";
+    inline constexpr std::string_view IdentifierStartChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+    inline constexpr std::string_view DigitChars = "0123456789";
+
+    // what the byte at the start of a token begins
+    enum class CharClass : uint8_t
+    {
+        Invalid,
+        Whitespace,
+        Identifier,
+        Number,
+        String,
+        Operator,
+        DotOrNumber, // '.' starts a number if a digit follows
+        NonAscii,    // lead byte of a multi-byte sequence, lexed as an identifier
+    };
+
+    constexpr std::array<CharClass, 256> BuildCharClasses()
+    {
+        std::array<CharClass, 256> table = {};
+
+        for (auto& op : Operators)
+            table[(unsigned char)op.text[0]] = CharClass::Operator;
+
+        for (auto c : WhitespaceChars)
+            table[(unsigned char)c] = CharClass::Whitespace;
+
+        for (auto c : IdentifierStartChars)
+            table[(unsigned char)c] = CharClass::Identifier;
+
+        for (auto c : DigitChars)
+            table[(unsigned char)c] = CharClass::Number;
+
+        table['\"'] = CharClass::String;
+        table['.'] = CharClass::DotOrNumber;
+
+        for (int c = 0x80; c < 0x100; ++c)
+            table[c] = CharClass::NonAscii;
+
+        return table;
+    }
+
+    inline constexpr std::array<CharClass, 256> CharClasses = BuildCharClasses();
+
+    constexpr std::array<bool, 256> BuildCharSet(std::string_view chars)
+    {
+        std::array<bool, 256> table = {};
+
+        for (auto c : chars)
+            table[(unsigned char)c] = true;
+
+        return table;
+    }
+
+    inline constexpr std::array<bool, 256> DigitSet = BuildCharSet(DigitChars);
+
+    inline bool IsDigit(char c) {
+        return DigitSet[(unsigned char)c];
+    }
+
+    constexpr std::array<int8_t, 256> BuildHexValues()
+    {
+        std::array<int8_t, 256> table = {};
+
+        for (auto& value : table)
+            value = -1;
+
+        for (int c = '0'; c <= '9'; ++c)
+            table[c] = (int8_t)(c - '0');
+
+        for (int c = 'a'; c <= 'f'; ++c) {
+            table[c] = (int8_t)(c - 'a' + 10);
+            table[c - 'a' + 'A'] = (int8_t)(c - 'a' + 10);
+        }
+
+        return table;
+    }
+
+    inline constexpr std::array<int8_t, 256> HexValues = BuildHexValues();
+
+    // value of a hex digit, or -1
+    inline int HexValue(char c) {
+        return HexValues[(unsigned char)c];
+    }
+
+    // Operator DFA: a trie over the operator spellings, walked with maximal munch.
+    // State 0 is the start state, and a transition to 0 means there is no transition.
+    constexpr size_t CountOperatorStates()
+    {
+        size_t chars = 0;
+        for (auto& op : Operators)
+            chars += op.text.size();
+        return chars + 1;
+    }
+
+    inline constexpr size_t MaxOperatorStates = CountOperatorStates();
+    static_assert(MaxOperatorStates <= 256, "operator DFA states must fit in a byte");
+
+    struct OperatorDFA
+    {
+        uint8_t next[MaxOperatorStates][256] = {};
+        TokenType accept[MaxOperatorStates] = {};
+        bool leaf[MaxOperatorStates] = {}; // no transitions out, so the walk can stop
+        size_t stateCount = 1;
+    };
+
+    constexpr OperatorDFA BuildOperatorDFA()
+    {
+        OperatorDFA dfa = {};
+
+        for (auto& accept : dfa.accept)
+            accept = TokenType::Invalid;
+
+        for (auto& op : Operators)
+        {
+            size_t state = 0;
+
+            for (auto c : op.text)
+            {
+                auto& next = dfa.next[state][(unsigned char)c];
+
+                if (next == 0)
+                    next = (uint8_t)dfa.stateCount++;
+
+                state = next;
+            }
+
+            dfa.accept[state] = op.type;
+        }
+
+        for (size_t state = 0; state < dfa.stateCount; ++state)
+        {
+            dfa.leaf[state] = true;
+
+            for (auto next : dfa.next[state])
+                dfa.leaf[state] = dfa.leaf[state] && next == 0;
+        }
+
+        return dfa;
+    }
+
+    inline constexpr OperatorDFA Operator = BuildOperatorDFA();
+
+    static_assert(Operator.accept[Operator.next[0][';']] == TokenType::Semicolon, "operator DFA is broken");
+}
@@ -4,9 +4,8 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <vector>
-#include <string>
-#include <memory>
+#include "Arena.h"
+#include "Symbol.h"
 #include "FunctionDefinition.h"
 #include "VariableDeclaration.h"
 #include "ASTNode.h"
@@ -14,15 +13,20 @@
 class ModuleDefinition : public ASTNode
 {
 public:
-    std::string id;
-    std::vector<sptr<VariableDeclaration>> variables;
-    std::vector<sptr<FunctionDefinition>> functions;
-    std::vector<sptr<ModuleDefinition>> modules;
+    Symbol id;
+    ArenaArray<VariableDeclaration*> variables;
+    ArenaArray<FunctionDefinition*> functions;
+    ArenaArray<ModuleDefinition*> modules;
 
-    ModuleDefinition() {}
+    ModuleDefinition()
+        : ASTNode(ASTNodeKind::ModuleDefinition) {}
 
-    ModuleDefinition(const std::string& id)
-        : id(id) {}
+    ModuleDefinition(Symbol id)
+        : ASTNode(ASTNodeKind::ModuleDefinition), id(id) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
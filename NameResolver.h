@@ -0,0 +1,363 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Symbol.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "VariableExpression.h"
+
+// Binds every variable and call in a translation unit to where it's stored, so later passes
+// index arrays instead of looking names up.
+//
+// A variable resolves to a (depth, slot) pair. Depth 0 is the root module. Each nested module
+// adds one level, and a function is one level below its module. Module variables are numbered
+// in declaration order. A function numbers its parameters first, then its local variables. A
+// slot is reused once the block that declared it ends, and FunctionDefinition::frameSize is
+// the most slots the function needs at once. A call resolves to an index in functions().
+//
+// Names are visible in the module or block that declares them and everything nested in it.
+// Inner names shadow outer ones. Module variables and functions can be used anywhere in their
+// module. A local variable can only be used after its declaration. Variables and functions have
+// separate names.
+//
+// Scopes are flat. Live bindings sit on one stack, innermost last, and closing a scope pops
+// back to where the scope started. Each symbol id indexes its innermost live binding, so a
+// lookup is two array reads, however deep the scopes go or however many names they hold.
+class NameResolver
+{
+public:
+    // functions every module can call, at the start of functions()
+    static constexpr const char* BuiltinNames[] = { "print" };
+    static constexpr uint32_t BuiltinCount = sizeof(BuiltinNames) / sizeof(BuiltinNames[0]);
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Binding
+    {
+        Symbol name;
+        uint32_t depth;
+        uint32_t slot;      // function index for functions
+        uint32_t shadowed;  // binding this one hides, or None
+    };
+
+    // live bindings, innermost last
+    std::vector<Binding> variableBindings;
+    std::vector<Binding> functionBindings;
+
+    // innermost live binding of each symbol id, or None
+    std::vector<uint32_t> innermostVariable;
+    std::vector<uint32_t> innermostFunction;
+
+    // first binding of the innermost scope, and of the current function's frame
+    uint32_t scopeStart = 0;
+    uint32_t frameStart = 0;
+    uint32_t frameSize = 0;
+
+    std::vector<ModuleDefinition*> modulePath;
+    FunctionDefinition* currentFunction = nullptr;
+
+    std::vector<Expression*> pending;
+    std::vector<FunctionDefinition*> functionTable;
+    std::vector<std::string> errorList;
+
+public:
+    // resolves every name in 'unit'. returns false if a name was undefined or defined twice in
+    // the same scope. everything else is resolved anyway, and errors() describes the problems.
+    // parses skipped function bodies.
+    bool Resolve(TranslationUnit& unit)
+    {
+        functionTable.clear();
+        errorList.clear();
+
+        for (uint32_t i = 0; i < BuiltinCount; ++i) {
+            functionTable.push_back(nullptr);
+            Bind(functionBindings, innermostFunction, Symbol::Intern(BuiltinNames[i]), 0, i, 0);
+        }
+
+        if (unit.rootModule)
+            ResolveModule(unit.rootModule, 0);
+
+        Unbind(functionBindings, innermostFunction, 0);
+        return errorList.empty();
+    }
+
+    // every function that can be called, by FunctionExpression::function. builtins are null.
+    const std::vector<FunctionDefinition*>& functions() const {
+        return functionTable;
+    }
+
+    const std::vector<std::string>& errors() const {
+        return errorList;
+    }
+
+    static bool IsBuiltin(uint32_t function) {
+        return function < BuiltinCount;
+    }
+
+private:
+
+    void ResolveModule(ModuleDefinition* mod, uint32_t depth)
+    {
+        auto variablesStart = (uint32_t)variableBindings.size();
+        auto functionsStart = (uint32_t)functionBindings.size();
+        auto outerScope = scopeStart;
+
+        modulePath.push_back(mod);
+        scopeStart = variablesStart;
+
+        // everything in the module is visible from the start of it
+        for (uint32_t i = 0; i < mod->variables.size(); ++i)
+        {
+            auto var = mod->variables[i];
+            var->depth = depth;
+            var->slot = i;
+
+            if (!Bind(variableBindings, innermostVariable, var->id, depth, i, variablesStart))
+                Error("redefinition of variable '", var->id, "'");
+        }
+
+        for (auto func : mod->functions)
+        {
+            func->index = (uint32_t)functionTable.size();
+            functionTable.push_back(func);
+
+            if (!Bind(functionBindings, innermostFunction, func->name, depth, func->index, functionsStart))
+                Error("redefinition of function '", func->name, "'");
+        }
+
+        for (auto var : mod->variables)
+            ResolveExpression(var->initializer);
+
+        for (auto func : mod->functions)
+            ResolveFunction(func, depth + 1);
+
+        for (auto nested : mod->modules)
+            ResolveModule(nested, depth + 1);
+
+        Unbind(variableBindings, innermostVariable, variablesStart);
+        Unbind(functionBindings, innermostFunction, functionsStart);
+
+        scopeStart = outerScope;
+        modulePath.pop_back();
+    }
+
+    void ResolveFunction(FunctionDefinition* func, uint32_t depth)
+    {
+        auto outerScope = scopeStart;
+
+        currentFunction = func;
+        frameStart = scopeStart = (uint32_t)variableBindings.size();
+        frameSize = (uint32_t)func->params.size();
+
+        for (uint32_t i = 0; i < func->params.size(); ++i)
+        {
+            auto param = func->params[i];
+            param->depth = depth;
+            param->slot = i;
+
+            if (!Bind(variableBindings, innermostVariable, param->id, depth, i, frameStart))
+                Error("redefinition of parameter '", param->id, "'");
+        }
+
+        // the outermost block shares the scope of the parameters
+        if (auto body = func->GetBody())
+        {
+            if (body->kind == ASTNodeKind::BlockStatement)
+                ResolveBlock(static_cast<BlockStatement*>(body), depth, frameStart);
+            else
+                ResolveStatement(body, depth);
+        }
+
+        func->frameSize = frameSize;
+
+        Unbind(variableBindings, innermostVariable, frameStart);
+        scopeStart = outerScope;
+        currentFunction = nullptr;
+    }
+
+    void ResolveBlock(BlockStatement* block, uint32_t depth, uint32_t start)
+    {
+        auto outerScope = scopeStart;
+        scopeStart = start;
+
+        for (auto stmt : block->statements)
+            ResolveStatement(stmt, depth);
+
+        Unbind(variableBindings, innermostVariable, start);
+        scopeStart = outerScope;
+    }
+
+    void ResolveStatement(Statement* stmt, uint32_t depth)
+    {
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            ResolveBlock(static_cast<BlockStatement*>(stmt), depth, (uint32_t)variableBindings.size());
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto var = static_cast<DeclarationStatement*>(stmt)->variableDeclaration;
+            if (!var)
+                break;
+
+            // the initializer can't see the variable it initializes
+            ResolveExpression(var->initializer);
+
+            var->depth = depth;
+            var->slot = (uint32_t)variableBindings.size() - frameStart;
+            frameSize = std::max(frameSize, var->slot + 1);
+
+            if (!Bind(variableBindings, innermostVariable, var->id, depth, var->slot, scopeStart))
+                Error("redefinition of variable '", var->id, "'");
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+            ResolveExpression(static_cast<ExpressionStatement*>(stmt)->expression);
+            break;
+
+        case ASTNodeKind::ReturnStatement:
+            ResolveExpression(static_cast<ReturnStatement*>(stmt)->expression);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // iterative, since expressions can nest deeper than the stack allows
+    void ResolveExpression(Expression* root)
+    {
+        if (!root)
+            return;
+
+        pending.push_back(root);
+
+        while (!pending.empty())
+        {
+            auto exp = pending.back();
+            pending.pop_back();
+
+            switch (exp->kind)
+            {
+            case ASTNodeKind::VariableExpression:
+            {
+                auto var = static_cast<VariableExpression*>(exp);
+                auto binding = Lookup(variableBindings, innermostVariable, var->name);
+
+                if (binding) {
+                    var->depth = binding->depth;
+                    var->slot = binding->slot;
+                }
+                else {
+                    Error("undefined variable '", var->name, "'");
+                }
+                break;
+            }
+
+            case ASTNodeKind::FunctionExpression:
+            {
+                auto call = static_cast<FunctionExpression*>(exp);
+                auto binding = Lookup(functionBindings, innermostFunction, call->name);
+
+                if (binding)
+                    call->function = binding->slot;
+                else
+                    Error("undefined function '", call->name, "'");
+
+                // in reverse, so they're resolved (and errors reported) from left to right
+                for (auto i = call->arguments.size(); i-- > 0; )
+                    pending.push_back(call->arguments[i]);
+                break;
+            }
+
+            case ASTNodeKind::BinaryExpression:
+            {
+                auto bin = static_cast<BinaryExpression*>(exp);
+                pending.push_back(bin->right);
+                pending.push_back(bin->left);
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+    }
+
+    // false if 'name' is already bound in the scope that starts at 'start'
+    static bool Bind(std::vector<Binding>& bindings, std::vector<uint32_t>& innermost,
+                     Symbol name, uint32_t depth, uint32_t slot, uint32_t start)
+    {
+        if (name.id >= innermost.size())
+            innermost.resize(std::max<size_t>(name.id + 1, SymbolTable::Global().size()), None);
+
+        auto shadowed = innermost[name.id];
+        bool redefined = shadowed != None && shadowed >= start;
+
+        innermost[name.id] = (uint32_t)bindings.size();
+        bindings.push_back(Binding{ name, depth, slot, shadowed });
+        return !redefined;
+    }
+
+    // closes the scopes back to the one whose first binding was 'start'
+    static void Unbind(std::vector<Binding>& bindings, std::vector<uint32_t>& innermost, uint32_t start)
+    {
+        while (bindings.size() > start) {
+            innermost[bindings.back().name.id] = bindings.back().shadowed;
+            bindings.pop_back();
+        }
+    }
+
+    static const Binding* Lookup(const std::vector<Binding>& bindings, const std::vector<uint32_t>& innermost, Symbol name)
+    {
+        if (name.id >= innermost.size() || innermost[name.id] == None)
+            return nullptr;
+
+        return &bindings[innermost[name.id]];
+    }
+
+    void Error(const char* before, Symbol name, const char* after)
+    {
+        std::string message = before;
+        message += name.str();
+        message += after;
+        message += " in ";
+
+        // the root module is implicit, so it's left out of the path
+        std::string where;
+
+        for (size_t i = 1; i < modulePath.size(); ++i) {
+            if (!where.empty())
+                where += '.';
+            where += modulePath[i]->id.str();
+        }
+
+        if (currentFunction) {
+            if (!where.empty())
+                where += '.';
+            where += currentFunction->name.str();
+        }
+
+        message += where.empty() ? std::string("global scope") : where;
+        errorList.push_back(std::move(message));
+    }
+};
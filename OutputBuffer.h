@@ -0,0 +1,144 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "Pointers.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Large, reusable output buffer that is written straight to a file descriptor (or appended to a
+// string) when it fills up, so producing big outputs costs a memcpy per piece and one system call
+// per buffer instead of stream formatting and intermediate strings.
+class OutputBuffer
+{
+    static constexpr size_t SpacesLength = 256;
+
+    int fd = -1;
+    std::string* target = nullptr;
+    uptr<char[]> buffer;
+    size_t capacity;
+    size_t used = 0;
+
+public:
+    static constexpr size_t DefaultCapacity = 1024 * 1024;
+
+    // writes to 'fd', which stays open
+    explicit OutputBuffer(int fd, size_t capacity = DefaultCapacity)
+        : fd(fd), buffer(new char[capacity]), capacity(capacity)
+    {
+    }
+
+    // appends to 'target'
+    explicit OutputBuffer(std::string& target, size_t capacity = DefaultCapacity)
+        : target(&target), buffer(new char[capacity]), capacity(capacity)
+    {
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // flush explicitly to find out about write errors
+    ~OutputBuffer()
+    {
+        try {
+            Flush();
+        }
+        catch (std::exception&) {
+        }
+    }
+
+    void Write(const char* data, size_t size)
+    {
+        if (capacity - used < size)
+        {
+            Flush();
+
+            if (size >= capacity) {
+                Emit(data, size);
+                return;
+            }
+        }
+
+        memcpy(buffer.get() + used, data, size);
+        used += size;
+    }
+
+    void Write(std::string_view text) {
+        Write(text.data(), text.size());
+    }
+
+    void Write(char c)
+    {
+        if (used == capacity)
+            Flush();
+
+        buffer[used++] = c;
+    }
+
+    void WriteInt(int64_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        Write(digits, result.ptr - digits);
+    }
+
+    // indentation comes from one shared run of spaces
+    void WriteSpaces(size_t count)
+    {
+        static const std::string spaces(SpacesLength, ' ');
+
+        for (; count > SpacesLength; count -= SpacesLength)
+            Write(spaces.data(), SpacesLength);
+
+        Write(spaces.data(), count);
+    }
+
+    void Flush()
+    {
+        if (used != 0) {
+            Emit(buffer.get(), used);
+            used = 0;
+        }
+    }
+
+private:
+
+    void Emit(const char* data, size_t size)
+    {
+        if (target) {
+            target->append(data, size);
+            return;
+        }
+
+        while (size != 0)
+        {
+#ifdef _WIN32
+            auto written = _write(fd, data, (unsigned int)std::min<size_t>(size, INT32_MAX));
+#else
+            auto written = ::write(fd, data, size);
+
+            if (written < 0 && errno == EINTR)
+                continue;
+#endif
+            if (written <= 0)
+                throw std::runtime_error("failed to write output");
+
+            data += written;
+            size -= (size_t)written;
+        }
+    }
+};
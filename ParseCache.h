@@ -0,0 +1,164 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <filesystem>
+#include <system_error>
+#include <stdexcept>
+#include "Pointers.h"
+#include "SourceBuffer.h"
+#include "ContentHash.h"
+#include "FlatAST.h"
+#include "TranslationUnit.h"
+
+// On-disk cache of parsed translation units, keyed by a hash of the source text, so a file
+// that hasn't changed since it was last parsed is loaded instead of lexed and parsed again.
+// Entries are serialized FlatASTs, memory mapped when they're loaded. Any number of threads
+// and processes can share a cache directory: entries are written to a temporary file and then
+// renamed into place, so a reader never sees a partial one.
+class ParseCache
+{
+public:
+    struct Statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stores = 0;
+        size_t bytesLoaded = 0;
+        size_t bytesStored = 0;
+    };
+
+private:
+    // stored in front of each serialized tree, to tell sources with the same hash apart
+    struct EntryHeader
+    {
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+    };
+
+    std::string directory;
+
+    std::atomic<size_t> hits { 0 };
+    std::atomic<size_t> misses { 0 };
+    std::atomic<size_t> stores { 0 };
+    std::atomic<size_t> bytesLoaded { 0 };
+    std::atomic<size_t> bytesStored { 0 };
+
+public:
+    explicit ParseCache(const std::string& directory)
+        : directory(directory)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        if (!std::filesystem::is_directory(directory))
+            throw std::runtime_error("failed to create cache directory: " + directory);
+    }
+
+    static uint64_t HashSource(const SourceBuffer& source) {
+        return ContentHash::Compute(source.data(), source.size());
+    }
+
+    // path of the entry for sources with 'hash'
+    std::string GetPath(uint64_t hash) const
+    {
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".ast";
+        return (std::filesystem::path(directory) / name.str()).string();
+    }
+
+    // the tree of 'source' if it's cached, otherwise null.
+    // entries that are stale, corrupt or from another version count as misses.
+    sptr<TranslationUnit> Load(const SourceBuffer& source)
+    {
+        auto hash = HashSource(source);
+        auto path = GetPath(hash);
+
+        std::error_code error;
+        if (std::filesystem::exists(path, error))
+        {
+            try
+            {
+                auto entry = SourceBuffer::FromFile(path);
+                EntryHeader header;
+
+                if (entry->size() >= sizeof(header))
+                {
+                    memcpy(&header, entry->data(), sizeof(header));
+
+                    if (header.sourceHash == hash && header.sourceSize == source.size())
+                    {
+                        auto ast = FlatAST::Deserialize(entry->data() + sizeof(header), entry->size() - sizeof(header));
+                        auto unit = ast.ToTree();
+
+                        ++hits;
+                        bytesLoaded += entry->size();
+                        return unit;
+                    }
+                }
+            }
+            catch (std::exception&)
+            {
+                // rewritten by the next Store
+            }
+        }
+
+        ++misses;
+        return nullptr;
+    }
+
+    // saves the tree of 'source', replacing any entry for a source with the same hash
+    void Store(const SourceBuffer& source, const TranslationUnit& unit)
+    {
+        EntryHeader header{ HashSource(source), source.size() };
+        auto bytes = FlatAST::FromTree(unit).Serialize();
+        auto path = GetPath(header.sourceHash);
+
+        // unique per thread and store, so concurrent stores of the same entry don't share a file
+        std::stringstream temp;
+        temp << path << "." << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id())
+             << "." << std::chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+
+        {
+            std::ofstream file(temp.str(), std::ios::binary | std::ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            file.write(bytes.data(), bytes.size());
+
+            if (!file)
+                throw std::runtime_error("failed to write cache entry: " + temp.str());
+        }
+
+        // fails on Windows while another process has the entry mapped. it has the same contents then.
+        std::error_code error;
+        std::filesystem::rename(temp.str(), path, error);
+
+        if (error) {
+            std::filesystem::remove(temp.str(), error);
+            return;
+        }
+
+        ++stores;
+        bytesStored += sizeof(header) + bytes.size();
+    }
+
+    Statistics statistics() const
+    {
+        Statistics ret;
+        ret.hits = hits;
+        ret.misses = misses;
+        ret.stores = stores;
+        ret.bytesLoaded = bytesLoaded;
+        ret.bytesStored = bytesStored;
+        return ret;
+    }
+};
@@ -5,15 +5,19 @@
 
 #pragma once
 #include "Lexer.h"
+#include "SourceMap.h"
 #include <string>
 #include <vector>
-#include <unordered_set>
 #include <memory>
 #include <stdexcept>
 #include <utility>
 #include <cassert>
+#include <climits>
 #include <unordered_map>
+#include <array>
 #include "Pointers.h"
+#include "Arena.h"
+#include "ThreadPool.h"
 #include "TranslationUnit.h"
 #include "FunctionDefinition.h"
 #include "FunctionParameter.h"
@@ -29,36 +33,164 @@
 #include "VariableExpression.h"
 #include "BinaryExpression.h"
 
-const std::unordered_set<std::string> keywords = {
-    "module",
-    "return"
-};
+namespace ParserTables
+{
+    struct BinaryOperatorSpec
+    {
+        TokenType type;
+        int precedence;
+    };
+
+    // all binary operators are left associative. higher precedence binds tighter.
+    inline constexpr BinaryOperatorSpec BinaryOperators[] = {
+        { TokenType::Plus,     0 },
+        { TokenType::Minus,    0 },
+        { TokenType::Multiply, 1 },
+        { TokenType::Divide,   1 },
+    };
+
+    constexpr std::array<int8_t, 256> BuildPrecedences()
+    {
+        std::array<int8_t, 256> table = {};
+
+        for (auto& precedence : table)
+            precedence = -1;
+
+        for (auto& op : BinaryOperators)
+            table[(uint8_t)op.type] = (int8_t)op.precedence;
+
+        return table;
+    }
+
+    inline constexpr std::array<int8_t, 256> Precedences = BuildPrecedences();
+
+    // precedence of a binary operator, or -1 if 'type' isn't one
+    inline int GetPrecedence(TokenType type) {
+        return Precedences[(uint8_t)type];
+    }
+}
 
 class Parser
 {
-    std::vector<Token> tokens;
+    // Tokens are pulled from 'lexer' as the parser needs them, so lexing and parsing are a single
+    // pass with no token array in between. Alternatively, they're read from a stream that was
+    // tokenized up front. Either way, tokens that were peeked at wait in a small ring buffer.
+    uptr<Lexer> lexer;
+    sptr<TokenStream> tokens;
     size_t index = 0;
+
+    // set for in-memory sources, which skipped function bodies can be parsed from later
+    sptr<SourceBuffer> source;
+    bool lazyFunctionBodies = false;
+
+    static constexpr size_t MaxLookahead = 4;
+    Token lookahead[MaxLookahead];
+    size_t lookaheadStart = 0;
+    size_t lookaheadCount = 0;
+
     Token token;
+
+    // nodes are allocated from the translation unit's arena. their child lists are collected on
+    // 'scratch' while they're being parsed, then copied into the arena in one piece.
+    Arena* arena = nullptr;
+    std::vector<ASTNode*> scratch;
+
+    // parses the function bodies that were skipped, from the same source or tokens into the same arena.
+    // owned by the translation unit, and only set while parsing with lazy function bodies.
+    struct BodyParser : public FunctionBodyParser
+    {
+        sptr<SourceBuffer> source;
+        sptr<TokenStream> tokens;
+        Arena* arena;
+
+        BodyParser(const sptr<SourceBuffer>& source, const sptr<TokenStream>& tokens, Arena* arena)
+            : source(source), tokens(tokens), arena(arena) {}
+
+        Statement* ParseBody(const LazyFunctionBody& body) override {
+            return Parse(body, arena);
+        }
+
+        // only reads the source or tokens, so any number of threads can parse into arenas of their own
+        Statement* Parse(const LazyFunctionBody& body, Arena* into) const
+        {
+            Parser parser(*this, body, into);
+            return parser.ParseStatement();
+        }
+    };
+
+    BodyParser* bodyParser = nullptr;
+    std::vector<std::pair<FunctionDefinition*, LazyFunctionBody*>> skippedBodies;
+
+    // Expressions are parsed without recursion: operands wait on 'operands', and binary operators,
+    // open parentheses and unfinished function calls on 'frames'. An operator reduces the operators
+    // on the stack that bind at least as tightly, so native stack use doesn't depend on how deeply
+    // nested or how long an expression is.
+    struct ExpressionFrame
+    {
+        enum Kind : uint8_t { Operator, Paren, Call };
+
+        Kind kind;
+        TokenType operation;      // Operator
+        int precedence;           // Operator
+        FunctionExpression* call; // Call
+        size_t arguments;         // Call: where its arguments start on 'scratch'
+    };
+
+    std::vector<Expression*> operands;
+    std::vector<ExpressionFrame> frames;
 public:
 
     Parser(const std::string& filename)
+        : Parser(SourceBuffer::FromFile(filename))
     {
-        Lexer lexer(filename);
-        lexer.Tokenize(tokens);
-        token = tokens[0];
+    }
+
+    Parser(const sptr<SourceBuffer>& source)
+        : lexer(new Lexer(source)), source(source)
+    {
+        token = Pull();
+    }
+
+    // parses input that is read a chunk at a time, in memory independent of its size
+    Parser(const sptr<SourceStream>& input)
+        : lexer(new Lexer(input))
+    {
+        token = Pull();
+    }
+
+    Parser(TokenStream tokens)
+        : tokens(spnew<TokenStream>(std::move(tokens)))
+    {
+        assert(!this->tokens->empty() && this->tokens->type(this->tokens->size() - 1) == TokenType::EndOfFile);
+        source = this->tokens->getSource();
+        token = Pull();
+    }
+
+    // Skips function bodies by matching braces instead of parsing them. Each body is parsed on the
+    // first FunctionDefinition::GetBody(), so passes that only need declarations don't pay for the
+    // statements. Streamed input can't be revisited, so its bodies are always parsed right away.
+    void SetLazyFunctionBodies(bool lazy) {
+        lazyFunctionBodies = lazy;
     }
 
     void Consume(TokenType tokenType, bool throwOnEOF)
     {
-        assert(index < tokens.size() - 1);
+        assert(token.type != TokenType::EndOfFile);
 
         if(tokenType != TokenType::Invalid && token.type != tokenType)
-            throw std::runtime_error("expected "s + Lexer::GetTokenName(tokenType));
+            Error("expected "s + Lexer::GetTokenName(tokenType));
 
-        token = tokens[++index];
+        if (lookaheadCount != 0) {
+            token = lookahead[lookaheadStart];
+            lookaheadStart = (lookaheadStart + 1) % MaxLookahead;
+            --lookaheadCount;
+        }
+        else {
+            token = Pull();
+        }
         
         if(throwOnEOF && token.type == TokenType::EndOfFile)
-            throw std::runtime_error("unexpected end of file");
+            Error("unexpected end of file");
     }
 
     void Consume(bool throwOnEOF) {
@@ -68,44 +200,143 @@ public:
     void Expect(TokenType tokenType, const std::string& tokenNameSubstitute = std::string())
     {
         if(tokenType != TokenType::Invalid && token.type != tokenType)
-            throw std::runtime_error("expected "s + (!tokenNameSubstitute.empty() ? tokenNameSubstitute : Lexer::GetTokenName(tokenType)));
+            Error("expected "s + (!tokenNameSubstitute.empty() ? tokenNameSubstitute : Lexer::GetTokenName(tokenType)));
     }
 
-    Token& currentToken() {
-        assert(index < tokens.size());
-        return tokens[index];
+    const Token& currentToken() const {
+        return token;
     }
 
-    Token& PeekToken(int ahead = 1) {
-        assert(index < tokens.size() - ahead);
-        return tokens[index + ahead];
+    // looks up to MaxLookahead tokens past the current one. past the end, it's the end of file token.
+    const Token& PeekToken(size_t ahead = 1)
+    {
+        assert(ahead >= 1 && ahead <= MaxLookahead);
+
+        while (lookaheadCount < ahead) {
+            lookahead[(lookaheadStart + lookaheadCount) % MaxLookahead] = Pull();
+            ++lookaheadCount;
+        }
+
+        return lookahead[(lookaheadStart + ahead - 1) % MaxLookahead];
     }
 
     void Enforce(bool condition, const std::string& error = std::string())
     {
         if (!condition)
-            throw std::runtime_error(error);
+            Error(error);
     }
 
-    sptr<TranslationUnit> ParseTranslationUnit()
+    // reports 'message' at the current token as file:line:column: message, or as
+    // offset N: message for a token stream that doesn't have its source.
+    // the source map is only built here, so successful parses never pay for it.
+    [[noreturn]] void Error(const std::string& message) const
+    {
+        std::string where;
+
+        if (lexer)
+            where = lexer->Describe(token.pos);
+        else if (tokens->getSource())
+            where = SourceMap(tokens->getSource()).Describe(token.pos);
+        else
+            where = "offset " + std::to_string(token.pos);
+
+        throw std::runtime_error(where + ": " + message);
+    }
+
+private:
+
+    // starts at the '{' of a skipped function body
+    Parser(const BodyParser& owner, const LazyFunctionBody& body, Arena* arena)
+        : tokens(owner.tokens), source(owner.source), arena(arena)
+    {
+        if (tokens)
+            index = tokens->Find(body.first);
+        else
+            lexer.reset(new Lexer(source, body.first, body.last + 1));
+
+        token = Pull();
+        assert(token.type == TokenType::LeftCurly && token.pos == body.first);
+    }
+
+    Token Pull()
+    {
+        if (lexer)
+        {
+            // the current token has to stay describable while the lexer reads ahead of it
+            lexer->Retain(token.pos);
+            return lexer->GetNextToken();
+        }
+
+        // the end of file token repeats, like the lexer's
+        auto ret = (*tokens)[index];
+        if (index + 1 < tokens->size())
+            ++index;
+
+        return ret;
+    }
+
+public:
+
+    sptr<TranslationUnit> ParseTranslationUnit() {
+        return Parse(lazyFunctionBodies);
+    }
+
+    // Parses the declarations with the function bodies skipped, then the bodies on 'pool', each
+    // worker into an arena of its own. The tree is the same as ParseTranslationUnit's, but when the
+    // source has several errors, one in a declaration is reported before any in a function body.
+    sptr<TranslationUnit> ParseTranslationUnit(ThreadPool& pool)
+    {
+        if (!source || pool.size() == 1)
+            return Parse(false);
+
+        auto ret = Parse(true);
+
+        ret->workerArenas.resize(pool.size());
+        for (auto& workerArena : ret->workerArenas)
+            workerArena.reset(new Arena());
+
+        pool.ForEach(skippedBodies.size(), [&](size_t i, size_t worker) {
+            auto& skipped = skippedBodies[i];
+            skipped.first->SetBody(bodyParser->Parse(*skipped.second, ret->workerArenas[worker].get()));
+        });
+
+        // every body is parsed
+        skippedBodies.clear();
+        bodyParser = nullptr;
+        ret->bodyParser.reset();
+
+        return ret;
+    }
+
+private:
+
+    sptr<TranslationUnit> Parse(bool skipFunctionBodies)
     {
         auto ret = spnew<TranslationUnit>();
+        arena = &ret->arena;
+
+        if (skipFunctionBodies && source)
+        {
+            bodyParser = new BodyParser(source, tokens, arena);
+            ret->bodyParser.reset(bodyParser);
+        }
         
-        ret->rootModule = spnew<ModuleDefinition>("global");
+        ret->rootModule = arena->New<ModuleDefinition>(Symbol::Intern("global"));
         ParseModuleBody(ret->rootModule);
 
         return ret;
     }
 
-    sptr<ModuleDefinition> ParseModule()
+public:
+
+    ModuleDefinition* ParseModule()
     {
-        auto ret = spnew<ModuleDefinition>();
+        auto ret = arena->New<ModuleDefinition>();
 
-        Enforce(token.type == TokenType::Identifier && token.storage.stringValue == "module", "expected 'module'");
-        Consume(true);
+        Consume(TokenType::Module, true);
         
         Expect(TokenType::Identifier, "module name");
-        ret->id = token.storage.stringValue;
+        ret->id = token.storage.symbol;
         Consume(true);
         
         Consume(TokenType::LeftCurly, true);
@@ -117,39 +348,46 @@ public:
         return ret;
     }
 
-    void ParseModuleBody(sptr<ModuleDefinition>& mod)
+    void ParseModuleBody(ModuleDefinition* mod)
     {
+        // the three kinds of members can be interleaved, so they can't share the scratch stack
+        std::vector<VariableDeclaration*> variables;
+        std::vector<FunctionDefinition*> functions;
+        std::vector<ModuleDefinition*> modules;
+
         while (token.type != TokenType::RightCurly && token.type != TokenType::EndOfFile)
         {
             switch (token.type)
             {
+            // module SomeModule { .. }
+            case TokenType::Module:
+            {
+                auto nestedMod = ParseModule();
+                modules.push_back(nestedMod);
+                break;
+            }
+
             case TokenType::Identifier:
-                // module SomeModule { .. }
-                if (token.storage.stringValue == "module")
+                if (PeekToken(1).type == TokenType::Identifier)
                 {
-                    auto nestedMod = ParseModule();
-                    mod->modules.push_back(nestedMod);
-                    break;
+                    auto next = PeekToken(2).type;
+
+                    // int Fun(params)
+                    if (next == TokenType::LeftParen)
+                    {
+                        auto func = ParseFunctionDefinition();
+                        functions.push_back(func);
+                    }
+                    // int Variable
+                    else
+                    {
+                        auto var = ParseVariableDeclaration();
+                        variables.push_back(var);
+                    }
                 }
                 else
                 {
-                    if (PeekToken(1).type == TokenType::Identifier)
-                    {
-                        auto next = PeekToken(2).type;
-
-                        // int Fun(params)
-                        if (next == TokenType::LeftParen)
-                        {
-                            auto func = ParseFunctionDefinition();
-                            mod->functions.push_back(std::move(func));
-                        }
-                        // int Variable
-                        else
-                        {
-                            auto var = ParseVariableDeclaration();
-                            mod->variables.push_back(var);
-                        }
-                    }
+                    Error("expected function or variable name");
                 }
                 break;
 
@@ -158,25 +396,29 @@ public:
                 break;
             }
         }
+
+        mod->variables = arena->NewArray(variables);
+        mod->functions = arena->NewArray(functions);
+        mod->modules = arena->NewArray(modules);
     }
 
-    sptr<VariableDeclaration> ParseVariableDeclaration()
+    VariableDeclaration* ParseVariableDeclaration()
     {
-        auto varDecl = spnew<VariableDeclaration>();
+        auto varDecl = arena->New<VariableDeclaration>();
         
         Expect(TokenType::Identifier, "a type name");
-        varDecl->typeName = token.storage.stringValue;
+        varDecl->typeName = token.storage.symbol;
 
         // consume type name
         Consume(true);
 
         Enforce(token.type == TokenType::Identifier, "expected variable name");
-        varDecl->id = token.storage.stringValue;
+        varDecl->id = token.storage.symbol;
 
         // consume variable name
         Consume(true);
         
-        sptr<Expression> initializer;
+        Expression* initializer;
 
         if (token.type == TokenType::Equals)
         {
@@ -184,49 +426,51 @@ public:
             Consume(true);
 
             // parse expression up to the next semicolon
-            initializer = ParseExpression(0);
+            initializer = ParseExpression();
         }
         else
         {
             // default value
-            initializer = spnew<Expression>();
+            initializer = arena->New<Expression>();
         }
 
         // consume semicolon
         Consume(TokenType::Semicolon, false);
 
-        varDecl->initializer = std::move(initializer);
+        varDecl->initializer = initializer;
 
         return varDecl;
     }
 
-    sptr<FunctionDefinition> ParseFunctionDefinition()
+    FunctionDefinition* ParseFunctionDefinition()
     {
-        auto func = spnew<FunctionDefinition>();
+        auto func = arena->New<FunctionDefinition>();
 
         Expect(TokenType::Identifier, "a type name");
-        func->returnTypeName = token.storage.stringValue;
+        func->returnTypeName = token.storage.symbol;
 
         Consume(true);
         
         Expect(TokenType::Identifier, "a function name");
-        func->name = token.storage.stringValue;
+        func->name = token.storage.symbol;
         Consume(true);
         
         Consume(TokenType::LeftParen, true);
 
+        auto params = scratch.size();
+
         while (token.type != TokenType::RightParen && token.type != TokenType::EndOfFile)
         {
             // parse function parameter
-            auto param = spnew<FunctionParameter>();
+            auto param = arena->New<FunctionParameter>();
 
             Expect(TokenType::Identifier, "a type name");
-            param->typeName = token.storage.stringValue;
+            param->typeName = token.storage.symbol;
             Consume(true);
             
             Expect(TokenType::Identifier, "a variable name");
-            param->id = token.storage.stringValue;
-            func->params.push_back(param);
+            param->id = token.storage.symbol;
+            scratch.push_back(param);
             Consume(true);
 
             if(token.type == TokenType::Comma) {
@@ -234,65 +478,132 @@ public:
             }
         }
 
+        func->params = PopScratch<FunctionParameter>(params);
+
         Consume(TokenType::RightParen, true);
 
         // following function definition, there should be a block statement
         Expect(TokenType::LeftCurly);
 
-        func->body = ParseStatement();
+        if (bodyParser)
+        {
+            auto body = SkipFunctionBody();
+            func->SetLazyBody(body);
+            skippedBodies.emplace_back(func, body);
+        }
+        else
+            func->SetBody(ParseStatement());
 
         return func;
     }
 
-    sptr<Statement> ParseStatement()
+    // consumes a block without parsing it, by matching braces
+    LazyFunctionBody* SkipFunctionBody()
     {
-        if (token.type == TokenType::LeftCurly)
+        assert(token.type == TokenType::LeftCurly && token.pos <= UINT32_MAX);
+        auto first = (uint32_t)token.pos;
+
+        if (lookaheadCount == 0)
+        {
+            // jump straight to the closing brace, without decoding the tokens in between
+            if (lexer)
+            {
+                token = lexer->SkipBlock();
+            }
+            else
+            {
+                for (size_t depth = 1;; ++index)
+                {
+                    auto type = tokens->type(index);
+
+                    if (type == TokenType::LeftCurly)
+                        ++depth;
+                    else if ((type == TokenType::RightCurly && --depth == 0) || type == TokenType::EndOfFile)
+                        break;
+                }
+
+                token = Pull();
+            }
+
+            if (token.type == TokenType::EndOfFile)
+                Error("unexpected end of file");
+        }
+        else
+        {
+            for (size_t depth = 0;;)
+            {
+                if (token.type == TokenType::LeftCurly)
+                    ++depth;
+                else if (token.type == TokenType::RightCurly && --depth == 0)
+                    break;
+
+                Consume(true);
+            }
+        }
+
+        auto last = (uint32_t)token.pos;
+        Consume(TokenType::RightCurly, false);
+
+        return arena->New<LazyFunctionBody>(LazyFunctionBody{ bodyParser, first, last });
+    }
+
+    Statement* ParseStatement()
+    {
+        switch (token.type)
+        {
+        case TokenType::LeftCurly:
         {
             // parse block statement
             Consume(true);
 
-            auto block = spnew<BlockStatement>();
+            auto block = arena->New<BlockStatement>();
+            auto statements = scratch.size();
 
             while (token.type != TokenType::RightCurly && token.type != TokenType::EndOfFile)
             {
                 auto stmt = ParseStatement();
-                block->statements.push_back(std::move(stmt));
+                scratch.push_back(stmt);
             }
 
+            block->statements = PopScratch<Statement>(statements);
+
             Consume(TokenType::RightCurly, false);
 
             return block;
         }
-        
-        if (token.type == TokenType::Identifier)
+
+        case TokenType::Return:
         {
-            auto& id = token.storage.stringValue;
-            if (id == "return")
-            {
-                // consume "return" keyword
-                Consume(true);
-                
-                auto stmt = spnew<ReturnStatement>();
+            // consume "return" keyword
+            Consume(true);
+            
+            auto stmt = arena->New<ReturnStatement>();
 
-                // parse return expression
-                stmt->expression = ParseExpression(0);
+            // parse return expression
+            stmt->expression = ParseExpression();
 
-                // final semicolon
-                Consume(TokenType::Semicolon, false);
+            // final semicolon
+            Consume(TokenType::Semicolon, false);
 
-                return stmt;
-            }
-            else if (PeekToken(1).type == TokenType::Identifier)
+            return stmt;
+        }
+
+        case TokenType::Identifier:
+            if (PeekToken(1).type == TokenType::Identifier)
             {
-                auto stmt = spnew<DeclarationStatement>();
+                auto stmt = arena->New<DeclarationStatement>();
                 stmt->variableDeclaration = ParseVariableDeclaration(); // probably shouldn't consume semicolon
                 return stmt;
             }
+            break;
+
+        default:
+            break;
         }
 
         // try to parse expression up to the next semicolon
-        auto stmt = spnew<ExpressionStatement>();
-        stmt->expression = ParseExpression(0);
+        auto stmt = arena->New<ExpressionStatement>();
+        stmt->expression = ParseExpression();
 
         // final semicolon
         Consume(TokenType::Semicolon, false);
@@ -300,105 +611,161 @@ public:
         return stmt;
     }
 
-    bool IsBinaryOperator(TokenType token)
-    {
-        return
-            token == TokenType::Plus ||
-            token == TokenType::Minus ||
-            token == TokenType::Multiply ||
-            token == TokenType::Divide;
+    bool IsBinaryOperator(TokenType type) {
+        return ParserTables::GetPrecedence(type) >= 0;
     }
 
-    int GetPrecendence(TokenType tok)
+    Expression* ParseExpression()
     {
-        switch (tok)
-        {
-        case TokenType::Plus:
-        case TokenType::Minus:
-            return 0;
-
-        case TokenType::Multiply:
-        case TokenType::Divide:
-            return 1;
+        auto operandBase = operands.size();
+        auto frameBase = frames.size();
 
-        default:
-            return -1;
-        }
-    }
+        for (;;)
+        {
+            // operand: any number of '(' and 'name(', then a primary expression
+            for (;;)
+            {
+                if (token.type == TokenType::LeftParen)
+                {
+                    // sub-expression
+                    Consume(true);
+                    frames.push_back(ExpressionFrame{ ExpressionFrame::Paren, TokenType::Invalid, 0, nullptr, 0 });
+                    continue;
+                }
 
-    sptr<Expression> ParseExpression(int precedence)
-    {
-        sptr<Expression> exp = ParseExpressionOperand();
+                if (token.type == TokenType::Identifier && PeekToken(1).type == TokenType::LeftParen)
+                {
+                    // function
+                    auto func = arena->New<FunctionExpression>();
 
-        while (IsBinaryOperator(token.type) && GetPrecendence(token.type) >= precedence)
-        {
-            auto op = token.type;
-            Consume(true);
+                    // function name
+                    func->name = token.storage.symbol;
+                    Consume(true);
 
-            auto right = ParseExpression(GetPrecendence(op) + 1);
-            exp = spnew<BinaryExpression>(op, exp, right);
-        }
+                    // '('
+                    Consume(TokenType::LeftParen, true);
 
-        return exp;
-    }
+                    frames.push_back(ExpressionFrame{ ExpressionFrame::Call, TokenType::Invalid, 0, func, scratch.size() });
 
-    sptr<Expression> ParseExpressionOperand()
-    {
-        if (token.type == TokenType::LeftParen)
-        {
-            // sub-expression
-            Consume(true);
+                    if (token.type == TokenType::RightParen || token.type == TokenType::EndOfFile)
+                    {
+                        // no (more) arguments
+                        operands.push_back(FinishCall());
+                        break;
+                    }
 
-            auto exp = ParseExpression(0);
+                    continue;
+                }
 
-            Consume(TokenType::RightParen, false);
+                operands.push_back(ParseExpressionOperand());
+                break;
+            }
 
-            return exp;
-        }
-        else if (token.type == TokenType::Identifier)
-        {
-            if (PeekToken(1).type == TokenType::LeftParen)
+            // operators and closing parentheses, until the next operand or the end of the expression
+            for (;;)
             {
-                // function
-                auto func = spnew<FunctionExpression>();
+                if (IsBinaryOperator(token.type))
+                {
+                    int precedence = ParserTables::GetPrecedence(token.type);
+                    ReduceOperators(frameBase, precedence);
 
-                // function name
-                func->name = token.storage.stringValue;
-                Consume(true);
+                    frames.push_back(ExpressionFrame{ ExpressionFrame::Operator, token.type, precedence, nullptr, 0 });
+                    Consume(true);
+                    break;
+                }
 
-                // '('
-                Consume(TokenType::LeftParen, true);
+                // whatever comes next ends the innermost parenthesis, argument, or the whole expression
+                ReduceOperators(frameBase, 0);
 
-                while (token.type != TokenType::RightParen && token.type != TokenType::EndOfFile)
+                if (frames.size() == frameBase)
                 {
-                    auto arg = ParseExpression(0);
-                    func->arguments.push_back(std::move(arg));
+                    assert(operands.size() == operandBase + 1);
+                    auto exp = operands.back();
+                    operands.pop_back();
+                    return exp;
+                }
 
-                    if (token.type == TokenType::Comma)
-                        Consume(true);
+                auto& frame = frames.back();
+
+                if (frame.kind == ExpressionFrame::Paren)
+                {
+                    Consume(TokenType::RightParen, false);
+                    frames.pop_back();
+                    continue;
                 }
 
-                // ')'
-                Consume(TokenType::RightParen, true);
+                assert(frame.kind == ExpressionFrame::Call);
 
-                return func;
-            }
-            else
-            {
-                // variable
-                auto var = spnew<VariableExpression>();
+                // argument
+                scratch.push_back(operands.back());
+                operands.pop_back();
 
-                // variable name
-                var->name = token.storage.stringValue;
-                Consume(true);
+                if (token.type == TokenType::Comma)
+                    Consume(true);
 
-                return var;
+                if (token.type == TokenType::RightParen || token.type == TokenType::EndOfFile) {
+                    operands.push_back(FinishCall());
+                    continue;
+                }
+
+                break;
             }
         }
+    }
+
+    // replaces operators of at least 'precedence' on top of the stack and their operands with binary expressions
+    void ReduceOperators(size_t frameBase, int precedence)
+    {
+        while (frames.size() > frameBase && frames.back().kind == ExpressionFrame::Operator && frames.back().precedence >= precedence)
+        {
+            auto op = frames.back().operation;
+            frames.pop_back();
+
+            assert(operands.size() >= 2);
+            auto right = operands.back();
+            operands.pop_back();
+            auto left = operands.back();
+
+            operands.back() = arena->New<BinaryExpression>(op, left, right);
+        }
+    }
+
+    // pops the call on top of the stack, and consumes its ')'
+    FunctionExpression* FinishCall()
+    {
+        auto frame = frames.back();
+        assert(frame.kind == ExpressionFrame::Call);
+        frames.pop_back();
+
+        frame.call->arguments = PopScratch<Expression>(frame.arguments);
+
+        // ')'
+        Consume(TokenType::RightParen, true);
+
+        return frame.call;
+    }
+
+    // primary expression
+    Expression* ParseExpressionOperand()
+    {
+        if (token.type == TokenType::Identifier)
+        {
+            // variable
+            auto var = arena->New<VariableExpression>();
+
+            // variable name
+            var->name = token.storage.symbol;
+            Consume(true);
+
+            return var;
+        }
         else if (token.type == TokenType::Integer)
         {
-            // primary expression
-            auto num = spnew<IntegerExpression>((int)token.storage.intValue);
+            // the lexer checks literals against int64, but IntegerExpression holds an int
+            if (token.storage.intValue > INT_MAX)
+                Error("integer literal is too large");
+
+            auto num = arena->New<IntegerExpression>(static_cast<int>(token.storage.intValue));
             Consume(true);
             return num;
         }
@@ -406,4 +773,19 @@ public:
         Enforce(false, "expected primary expression");
         return nullptr;
     }
+
+    // moves the nodes pushed on 'scratch' since 'mark' into an arena array
+    template<class T>
+    ArenaArray<T*> PopScratch(size_t mark)
+    {
+        assert(mark <= scratch.size());
+
+        auto ret = arena->NewArray<T*>(scratch.size() - mark);
+
+        for (size_t i = 0; i < ret.size(); ++i)
+            ret[i] = static_cast<T*>(scratch[mark + i]);
+
+        scratch.resize(mark);
+        return ret;
+    }
 };
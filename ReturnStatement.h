@@ -11,7 +11,14 @@
 class ReturnStatement : public Statement
 {
 public:
-    sptr<Expression> expression;
+    Expression* expression = nullptr;
+
+    ReturnStatement()
+        : Statement(ASTNodeKind::ReturnStatement) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
@@ -0,0 +1,338 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SCAN_KERNELS_X86) && (defined(_MSC_VER) || defined(__GNUC__))
+#define SCAN_KERNELS_AVX2 1
+#ifdef _MSC_VER
+#define SCAN_TARGET_AVX2
+#else
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Kernels that find the end of a run of bytes of one class, 16 or 32 bytes at a time.
+// Each takes [p, end) and returns the first byte that doesn't belong to the run, or 'end'.
+// Only ASCII bytes are ever part of a run, so multi-byte UTF-8 sequences always stop a scan.
+// FindNewlines collects line break offsets for SourceMap the same way.
+struct ScanKernels
+{
+    // ' ', '\t', '\n', '\v', '\f', '\r'
+    const char* (*SkipWhitespace)(const char* p, const char* end);
+
+    // [A-Za-z0-9_]
+    const char* (*SkipIdentifier)(const char* p, const char* end);
+
+    // anything but '"', '\\' and non-ASCII bytes
+    const char* (*SkipStringBody)(const char* p, const char* end);
+
+    // appends the offset from 'base' of every '\n' in [p, end)
+    void (*FindNewlines)(const char* p, const char* end, const char* base, std::vector<uint32_t>& offsets);
+
+    const char* name;
+
+    // kernels for the best instruction set this CPU supports, detected once
+    static const ScanKernels& Get()
+    {
+        static const ScanKernels kernels = Select();
+        return kernels;
+    }
+
+    static const ScanKernels& Scalar()
+    {
+        static const ScanKernels kernels { ScalarSkipWhitespace, ScalarSkipIdentifier, ScalarSkipStringBody, ScalarFindNewlines, "scalar" };
+        return kernels;
+    }
+
+#ifdef SCAN_KERNELS_X86
+    static const ScanKernels& SSE2()
+    {
+        static const ScanKernels kernels { SSE2SkipWhitespace, SSE2SkipIdentifier, SSE2SkipStringBody, SSE2FindNewlines, "sse2" };
+        return kernels;
+    }
+#endif
+
+#ifdef SCAN_KERNELS_AVX2
+    static const ScanKernels& AVX2()
+    {
+        static const ScanKernels kernels { AVX2SkipWhitespace, AVX2SkipIdentifier, AVX2SkipStringBody, AVX2FindNewlines, "avx2" };
+        return kernels;
+    }
+#endif
+
+    static bool IsWhitespace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    static bool IsIdentifierChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    static bool IsStringBodyChar(char c) {
+        return c != '\"' && c != '\\' && (unsigned char)c < 0x80;
+    }
+
+private:
+
+    static ScanKernels Select()
+    {
+#ifdef SCAN_KERNELS_AVX2
+        if (HasAVX2())
+            return AVX2();
+#endif
+#ifdef SCAN_KERNELS_X86
+        return SSE2();
+#else
+        return Scalar();
+#endif
+    }
+
+    static const char* ScalarSkipWhitespace(const char* p, const char* end)
+    {
+        while (p != end && IsWhitespace(*p))
+            ++p;
+        return p;
+    }
+
+    static const char* ScalarSkipIdentifier(const char* p, const char* end)
+    {
+        while (p != end && IsIdentifierChar(*p))
+            ++p;
+        return p;
+    }
+
+    static const char* ScalarSkipStringBody(const char* p, const char* end)
+    {
+        while (p != end && IsStringBodyChar(*p))
+            ++p;
+        return p;
+    }
+
+    static void ScalarFindNewlines(const char* p, const char* end, const char* base, std::vector<uint32_t>& offsets)
+    {
+        for (; p != end; ++p)
+        {
+            if (*p == '\n')
+                offsets.push_back((uint32_t)(p - base));
+        }
+    }
+
+#ifdef SCAN_KERNELS_X86
+
+    static unsigned CountTrailingZeros(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+
+    // unsigned lo <= x <= hi, per byte
+    static __m128i InRange(__m128i x, uint8_t lo, uint8_t hi)
+    {
+        auto geLo = _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8((char)lo)), x);
+        auto leHi = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8((char)hi)), x);
+        return _mm_and_si128(geLo, leHi);
+    }
+
+    static __m128i SSE2WhitespaceMask(__m128i x) {
+        return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), InRange(x, '\t', '\r'));
+    }
+
+    static __m128i SSE2IdentifierMask(__m128i x)
+    {
+        auto lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        auto alpha = InRange(lower, 'a', 'z');
+        auto digit = InRange(x, '0', '9');
+        auto under = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+        return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+    }
+
+    static __m128i SSE2StringBodyMask(__m128i x)
+    {
+        // movemask of the inverse picks up quotes, backslashes and any byte with the high bit set
+        auto quote = _mm_cmpeq_epi8(x, _mm_set1_epi8('\"'));
+        auto slash = _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'));
+        return _mm_andnot_si128(_mm_or_si128(_mm_or_si128(quote, slash), _mm_cmplt_epi8(x, _mm_setzero_si128())), _mm_set1_epi8(-1));
+    }
+
+    template<__m128i (*InRun)(__m128i), bool (*IsRunChar)(char)>
+    static const char* SSE2Skip(const char* p, const char* end)
+    {
+        while (end - p >= 16)
+        {
+            auto x = _mm_loadu_si128((const __m128i*)p);
+            auto stop = ~(uint32_t)_mm_movemask_epi8(InRun(x)) & 0xFFFFu;
+
+            if (stop)
+                return p + CountTrailingZeros(stop);
+
+            p += 16;
+        }
+
+        while (p != end && IsRunChar(*p))
+            ++p;
+
+        return p;
+    }
+
+    static const char* SSE2SkipWhitespace(const char* p, const char* end) {
+        return SSE2Skip<SSE2WhitespaceMask, IsWhitespace>(p, end);
+    }
+
+    static const char* SSE2SkipIdentifier(const char* p, const char* end) {
+        return SSE2Skip<SSE2IdentifierMask, IsIdentifierChar>(p, end);
+    }
+
+    static const char* SSE2SkipStringBody(const char* p, const char* end) {
+        return SSE2Skip<SSE2StringBodyMask, IsStringBodyChar>(p, end);
+    }
+
+    static void SSE2FindNewlines(const char* p, const char* end, const char* base, std::vector<uint32_t>& offsets)
+    {
+        auto newline = _mm_set1_epi8('\n');
+
+        while (end - p >= 16)
+        {
+            auto x = _mm_loadu_si128((const __m128i*)p);
+            auto mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, newline));
+
+            for (; mask; mask &= mask - 1)
+                offsets.push_back((uint32_t)(p - base) + CountTrailingZeros(mask));
+
+            p += 16;
+        }
+
+        ScalarFindNewlines(p, end, base, offsets);
+    }
+
+#endif // SCAN_KERNELS_X86
+
+#ifdef SCAN_KERNELS_AVX2
+
+    static bool HasAVX2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // the OS has to save the upper halves of the ymm registers
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    SCAN_TARGET_AVX2 static __m256i InRange256(__m256i x, uint8_t lo, uint8_t hi)
+    {
+        auto geLo = _mm256_cmpeq_epi8(_mm256_max_epu8(x, _mm256_set1_epi8((char)lo)), x);
+        auto leHi = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8((char)hi)), x);
+        return _mm256_and_si256(geLo, leHi);
+    }
+
+    SCAN_TARGET_AVX2 static uint32_t AVX2WhitespaceStops(__m256i x) {
+        auto ws = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), InRange256(x, '\t', '\r'));
+        return ~(uint32_t)_mm256_movemask_epi8(ws);
+    }
+
+    SCAN_TARGET_AVX2 static uint32_t AVX2IdentifierStops(__m256i x)
+    {
+        auto lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        auto alpha = InRange256(lower, 'a', 'z');
+        auto digit = InRange256(x, '0', '9');
+        auto under = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+        return ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), under));
+    }
+
+    SCAN_TARGET_AVX2 static uint32_t AVX2StringBodyStops(__m256i x)
+    {
+        auto quote = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\"'));
+        auto slash = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'));
+        return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(quote, slash), x));
+    }
+
+    SCAN_TARGET_AVX2 static const char* AVX2SkipWhitespace(const char* p, const char* end)
+    {
+        while (end - p >= 32)
+        {
+            auto stop = AVX2WhitespaceStops(_mm256_loadu_si256((const __m256i*)p));
+            if (stop)
+                return p + CountTrailingZeros(stop);
+            p += 32;
+        }
+
+        return SSE2SkipWhitespace(p, end);
+    }
+
+    SCAN_TARGET_AVX2 static const char* AVX2SkipIdentifier(const char* p, const char* end)
+    {
+        while (end - p >= 32)
+        {
+            auto stop = AVX2IdentifierStops(_mm256_loadu_si256((const __m256i*)p));
+            if (stop)
+                return p + CountTrailingZeros(stop);
+            p += 32;
+        }
+
+        return SSE2SkipIdentifier(p, end);
+    }
+
+    SCAN_TARGET_AVX2 static const char* AVX2SkipStringBody(const char* p, const char* end)
+    {
+        while (end - p >= 32)
+        {
+            auto stop = AVX2StringBodyStops(_mm256_loadu_si256((const __m256i*)p));
+            if (stop)
+                return p + CountTrailingZeros(stop);
+            p += 32;
+        }
+
+        return SSE2SkipStringBody(p, end);
+    }
+
+    SCAN_TARGET_AVX2 static void AVX2FindNewlines(const char* p, const char* end, const char* base, std::vector<uint32_t>& offsets)
+    {
+        auto newline = _mm256_set1_epi8('\n');
+
+        while (end - p >= 32)
+        {
+            auto x = _mm256_loadu_si256((const __m256i*)p);
+            auto mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, newline));
+
+            for (; mask; mask &= mask - 1)
+                offsets.push_back((uint32_t)(p - base) + CountTrailingZeros(mask));
+
+            p += 32;
+        }
+
+        SSE2FindNewlines(p, end, base, offsets);
+    }
+
+#endif // SCAN_KERNELS_AVX2
+};
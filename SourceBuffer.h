@@ -0,0 +1,251 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include "Pointers.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std::string_literals;
+
+// Read-only view of a source file's bytes.
+// Regular files are memory mapped, so opening is O(1) and pages are only faulted in
+// as the lexer advances. Pipes and stdin fall back to read() into owned storage.
+class SourceBuffer
+{
+    std::string name;
+    const char* bytes = nullptr;
+    size_t length = 0;
+    std::string storage;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    void* mapped = nullptr;
+#endif
+
+    struct Private {};
+
+public:
+    SourceBuffer(Private) {}
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    ~SourceBuffer()
+    {
+#ifdef _WIN32
+        if (mapping) {
+            UnmapViewOfFile(bytes);
+            CloseHandle(mapping);
+        }
+
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (mapped)
+            munmap(mapped, length);
+#endif
+    }
+
+    const char* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    const std::string& filename() const {
+        return name;
+    }
+
+    // maps 'filename' into memory, or reads it if it can't be mapped. "-" reads stdin.
+    static sptr<SourceBuffer> FromFile(const std::string& filename)
+    {
+        if (filename == "-")
+            return FromStdin();
+
+        auto buffer = spnew<SourceBuffer>(Private());
+        buffer->name = filename;
+
+#ifdef _WIN32
+        buffer->file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (buffer->file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("failed to open file: "s + filename);
+
+        if (GetFileType(buffer->file) != FILE_TYPE_DISK)
+        {
+            int fd = _open_osfhandle((intptr_t)buffer->file, 0);
+            buffer->file = INVALID_HANDLE_VALUE;
+            buffer->ReadAll(fd);
+            _close(fd);
+            return buffer;
+        }
+
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(buffer->file, &sz))
+            throw std::runtime_error("failed to read file: "s + filename);
+
+        buffer->length = (size_t)sz.QuadPart;
+
+        // empty files can't be mapped
+        if (buffer->length == 0)
+            return buffer;
+
+        buffer->mapping = CreateFileMappingA(buffer->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!buffer->mapping)
+            throw std::runtime_error("failed to map file: "s + filename);
+
+        buffer->bytes = (const char*)MapViewOfFile(buffer->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!buffer->bytes)
+            throw std::runtime_error("failed to map file: "s + filename);
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("failed to open file: "s + filename);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            try {
+                buffer->ReadAll(fd);
+            }
+            catch (...) {
+                close(fd);
+                throw;
+            }
+
+            close(fd);
+            return buffer;
+        }
+
+        buffer->length = (size_t)st.st_size;
+
+        // empty files can't be mapped
+        if (buffer->length != 0)
+        {
+            void* addr = mmap(nullptr, buffer->length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (addr == MAP_FAILED)
+            {
+                buffer->length = 0;
+
+                try {
+                    buffer->ReadAll(fd);
+                }
+                catch (...) {
+                    close(fd);
+                    throw;
+                }
+            }
+            else
+            {
+                madvise(addr, buffer->length, MADV_SEQUENTIAL);
+                buffer->mapped = addr;
+                buffer->bytes = (const char*)addr;
+            }
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+#endif
+
+        return buffer;
+    }
+
+    // reads all of standard input
+    static sptr<SourceBuffer> FromStdin()
+    {
+        auto buffer = spnew<SourceBuffer>(Private());
+        buffer->name = "<stdin>";
+#ifdef _WIN32
+        buffer->ReadAll(_fileno(stdin));
+#else
+        buffer->ReadAll(fileno(stdin));
+#endif
+        return buffer;
+    }
+
+    // takes ownership of a source that is already in memory
+    static sptr<SourceBuffer> FromMemory(std::string text, const std::string& name = "<memory>")
+    {
+        auto buffer = spnew<SourceBuffer>(Private());
+        buffer->name = name;
+        buffer->storage = std::move(text);
+        buffer->bytes = buffer->storage.data();
+        buffer->length = buffer->storage.size();
+        return buffer;
+    }
+
+    // references memory owned by the caller, which must outlive the buffer
+    static sptr<SourceBuffer> FromMemory(const char* data, size_t size, const std::string& name = "<memory>")
+    {
+        auto buffer = spnew<SourceBuffer>(Private());
+        buffer->name = name;
+        buffer->bytes = data;
+        buffer->length = size;
+        return buffer;
+    }
+
+private:
+
+    void ReadAll(int fd)
+    {
+        const size_t chunkSize = 64 * 1024;
+        size_t used = 0;
+
+        for (;;)
+        {
+            storage.resize(used + chunkSize);
+
+#ifdef _WIN32
+            auto n = _read(fd, &storage[used], (unsigned int)chunkSize);
+#else
+            auto n = read(fd, &storage[used], chunkSize);
+
+            if (n < 0 && errno == EINTR)
+                continue;
+#endif
+            if (n < 0)
+                throw std::runtime_error("failed to read file: "s + name);
+
+            if (n == 0)
+                break;
+
+            used += (size_t)n;
+        }
+
+        storage.resize(used);
+        bytes = storage.data();
+        length = storage.size();
+    }
+};
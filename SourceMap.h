@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include "Pointers.h"
+#include "SourceBuffer.h"
+#include "ScanKernels.h"
+
+struct SourceLocation
+{
+    size_t line;   // 1-based
+    size_t column; // 1-based, with tabs moving to the next multiple of the map's tab length
+};
+
+// Maps byte offsets in a source buffer to line and column.
+// The newline index is only built the first time a location is asked for,
+// so lexing and parsing don't pay for line tracking unless there's a diagnostic.
+class SourceMap
+{
+    sptr<SourceBuffer> source;
+    int tabLength;
+    mutable std::once_flag indexed;
+    mutable std::vector<uint32_t> newlines;
+
+public:
+    SourceMap(const sptr<SourceBuffer>& source, int tabLength = 4)
+        : source(source), tabLength(tabLength)
+    {
+    }
+
+    SourceLocation GetLocation(size_t pos) const
+    {
+        assert(pos <= source->size());
+
+        std::call_once(indexed, [this] {
+            auto data = source->data();
+            ScanKernels::Get().FindNewlines(data, data + source->size(), data, newlines);
+        });
+
+        // the number of newlines before 'pos' is the zero-based line number
+        auto it = std::lower_bound(newlines.begin(), newlines.end(), (uint32_t)pos);
+        size_t line = it - newlines.begin();
+        size_t lineStart = line == 0 ? 0 : newlines[line - 1] + 1;
+
+        auto data = source->data();
+        size_t column = CountColumns(data + lineStart, data + pos, tabLength);
+        return SourceLocation{ line + 1, column + 1 };
+    }
+
+    // "file:line:column"
+    std::string Describe(size_t pos) const {
+        return Describe(source->filename(), GetLocation(pos));
+    }
+
+    static std::string Describe(const std::string& filename, SourceLocation loc) {
+        return filename + ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+    }
+
+    // location of 'end', given the location of 'p'.
+    // for sources that are only ever seen a window at a time, like the streaming lexer's.
+    static SourceLocation Advance(SourceLocation loc, const char* p, const char* end, int tabLength = 4)
+    {
+        std::vector<uint32_t> offsets;
+        ScanKernels::Get().FindNewlines(p, end, p, offsets);
+
+        if (!offsets.empty())
+        {
+            loc.line += offsets.size();
+            loc.column = 1;
+            p += offsets.back() + 1;
+        }
+
+        loc.column = CountColumns(p, end, tabLength, loc.column - 1) + 1;
+        return loc;
+    }
+
+private:
+
+    // zero-based column of 'end', given the zero-based column of 'p'
+    static size_t CountColumns(const char* p, const char* end, int tabLength, size_t column = 0)
+    {
+        for (; p != end; ++p)
+        {
+            if (*p == '\t')
+                column += tabLength - column % tabLength;
+            else if (((unsigned char)*p & 0xC0) != 0x80) // count code points, not continuation bytes
+                ++column;
+        }
+
+        return column;
+    }
+};
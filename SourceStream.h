@@ -0,0 +1,152 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "Pointers.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std::string_literals;
+
+// Sequential, chunked reader over a source file, stdin or any other producer of bytes.
+// Unlike SourceBuffer, nothing is kept after it's read, so the streaming Lexer can work
+// through inputs of any size with a fixed amount of memory.
+class SourceStream
+{
+    std::string name;
+    std::function<size_t(char*, size_t)> reader;
+    int fd = -1;
+    bool exhausted = false;
+
+    struct Private {};
+
+public:
+    SourceStream(Private) {}
+
+    SourceStream(const SourceStream&) = delete;
+    SourceStream& operator=(const SourceStream&) = delete;
+
+    ~SourceStream()
+    {
+        if (fd >= 0) {
+#ifdef _WIN32
+            _close(fd);
+#else
+            close(fd);
+#endif
+        }
+    }
+
+    const std::string& filename() const {
+        return name;
+    }
+
+    // true once a read has come back empty
+    bool done() const {
+        return exhausted;
+    }
+
+    // reads up to 'capacity' bytes into 'dst'. returns 0 only at the end of the input.
+    size_t Read(char* dst, size_t capacity)
+    {
+        if (exhausted || capacity == 0)
+            return 0;
+
+        size_t n = reader(dst, capacity);
+        exhausted = n == 0;
+        return n;
+    }
+
+    // opens 'filename' for reading. "-" reads stdin.
+    static sptr<SourceStream> FromFile(const std::string& filename)
+    {
+        if (filename == "-")
+            return FromStdin();
+
+#ifdef _WIN32
+        int fd = _open(filename.c_str(), _O_RDONLY | _O_BINARY | _O_SEQUENTIAL);
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+#endif
+        if (fd < 0)
+            throw std::runtime_error("failed to open file: "s + filename);
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        auto stream = FromDescriptor(fd, filename);
+        stream->fd = fd;
+        return stream;
+    }
+
+    static sptr<SourceStream> FromStdin()
+    {
+#ifdef _WIN32
+        return FromDescriptor(_fileno(stdin), "<stdin>");
+#else
+        return FromDescriptor(fileno(stdin), "<stdin>");
+#endif
+    }
+
+    // reads from memory owned by the caller, which must outlive the stream
+    static sptr<SourceStream> FromMemory(const char* data, size_t size, const std::string& name = "<memory>")
+    {
+        size_t pos = 0;
+
+        return FromReader([=](char* dst, size_t capacity) mutable {
+            size_t n = std::min(capacity, size - pos);
+            memcpy(dst, data + pos, n);
+            pos += n;
+            return n;
+        }, name);
+    }
+
+    // 'reader' fills up to 'capacity' bytes and returns how many it wrote, or 0 at the end of the input
+    static sptr<SourceStream> FromReader(std::function<size_t(char*, size_t)> reader, const std::string& name)
+    {
+        auto stream = spnew<SourceStream>(Private());
+        stream->name = name;
+        stream->reader = std::move(reader);
+        return stream;
+    }
+
+private:
+
+    static sptr<SourceStream> FromDescriptor(int fd, const std::string& name)
+    {
+        return FromReader([fd, name](char* dst, size_t capacity) -> size_t {
+            for (;;)
+            {
+#ifdef _WIN32
+                auto n = _read(fd, dst, (unsigned int)std::min(capacity, (size_t)INT32_MAX));
+#else
+                auto n = read(fd, dst, capacity);
+
+                if (n < 0 && errno == EINTR)
+                    continue;
+#endif
+                if (n < 0)
+                    throw std::runtime_error("failed to read file: "s + name);
+
+                return (size_t)n;
+            }
+        }, name);
+    }
+};
@@ -9,7 +9,12 @@
 class Statement : public ASTNode
 {
 public:
-    ~Statement(){}
+    explicit Statement(ASTNodeKind kind = ASTNodeKind::Statement)
+        : ASTNode(kind) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
@@ -0,0 +1,192 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include "ASTNode.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "ImportStatement.h"
+#include "Statement.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "Expression.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "IntegerExpression.h"
+#include "VariableExpression.h"
+
+// Visitor that dispatches on ASTNode::kind with a switch instead of virtual calls, so the Visit
+// functions of the derived class can be inlined into the traversal.
+// 'Derived' defines any of the Visit functions below. The ones it doesn't define fall back to those
+// of the node's base class (VisitBinaryExpression -> VisitExpression -> VisitNode), so a pass only
+// writes the cases it cares about. Every Visit function returns R.
+template<class Derived, class R = void>
+class StaticASTVisitor
+{
+public:
+    R Dispatch(ASTNode* node)
+    {
+        switch (node->kind)
+        {
+        case ASTNodeKind::TranslationUnit:      return derived().VisitTranslationUnit(static_cast<TranslationUnit*>(node));
+        case ASTNodeKind::ModuleDefinition:     return derived().VisitModuleDefinition(static_cast<ModuleDefinition*>(node));
+        case ASTNodeKind::FunctionDefinition:   return derived().VisitFunctionDefinition(static_cast<FunctionDefinition*>(node));
+        case ASTNodeKind::FunctionParameter:    return derived().VisitFunctionParameter(static_cast<FunctionParameter*>(node));
+        case ASTNodeKind::VariableDeclaration:  return derived().VisitVariableDeclaration(static_cast<VariableDeclaration*>(node));
+        case ASTNodeKind::ImportStatement:      return derived().VisitImportStatement(static_cast<ImportStatement*>(node));
+        case ASTNodeKind::Statement:            return derived().VisitStatement(static_cast<Statement*>(node));
+        case ASTNodeKind::BlockStatement:       return derived().VisitBlockStatement(static_cast<BlockStatement*>(node));
+        case ASTNodeKind::DeclarationStatement: return derived().VisitDeclarationStatement(static_cast<DeclarationStatement*>(node));
+        case ASTNodeKind::ExpressionStatement:  return derived().VisitExpressionStatement(static_cast<ExpressionStatement*>(node));
+        case ASTNodeKind::ReturnStatement:      return derived().VisitReturnStatement(static_cast<ReturnStatement*>(node));
+        case ASTNodeKind::Expression:           return derived().VisitExpression(static_cast<Expression*>(node));
+        case ASTNodeKind::BinaryExpression:     return derived().VisitBinaryExpression(static_cast<BinaryExpression*>(node));
+        case ASTNodeKind::FunctionExpression:   return derived().VisitFunctionExpression(static_cast<FunctionExpression*>(node));
+        case ASTNodeKind::IntegerExpression:    return derived().VisitIntegerExpression(static_cast<IntegerExpression*>(node));
+        case ASTNodeKind::VariableExpression:   return derived().VisitVariableExpression(static_cast<VariableExpression*>(node));
+        }
+
+        return derived().VisitNode(node);
+    }
+
+    R VisitNode(ASTNode* node) { return R(); }
+
+    R VisitTranslationUnit(TranslationUnit* node) { return derived().VisitNode(node); }
+    R VisitModuleDefinition(ModuleDefinition* node) { return derived().VisitNode(node); }
+    R VisitFunctionDefinition(FunctionDefinition* node) { return derived().VisitNode(node); }
+    R VisitFunctionParameter(FunctionParameter* node) { return derived().VisitNode(node); }
+    R VisitVariableDeclaration(VariableDeclaration* node) { return derived().VisitNode(node); }
+    R VisitImportStatement(ImportStatement* node) { return derived().VisitNode(node); }
+
+    R VisitStatement(Statement* node) { return derived().VisitNode(node); }
+    R VisitBlockStatement(BlockStatement* node) { return derived().VisitStatement(node); }
+    R VisitDeclarationStatement(DeclarationStatement* node) { return derived().VisitStatement(node); }
+    R VisitExpressionStatement(ExpressionStatement* node) { return derived().VisitStatement(node); }
+    R VisitReturnStatement(ReturnStatement* node) { return derived().VisitStatement(node); }
+
+    R VisitExpression(Expression* node) { return derived().VisitNode(node); }
+    R VisitBinaryExpression(BinaryExpression* node) { return derived().VisitExpression(node); }
+    R VisitFunctionExpression(FunctionExpression* node) { return derived().VisitExpression(node); }
+    R VisitIntegerExpression(IntegerExpression* node) { return derived().VisitExpression(node); }
+    R VisitVariableExpression(VariableExpression* node) { return derived().VisitExpression(node); }
+
+protected:
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+// StaticASTVisitor that visits every node under the one it's given, parents before children.
+// 'Derived' can define Traverse to change how (or whether) a subtree is walked, and call
+// StaticASTWalker::Traverse to continue. Skipped function bodies are parsed on the way.
+template<class Derived>
+class StaticASTWalker : public StaticASTVisitor<Derived, void>
+{
+public:
+    void Traverse(ASTNode* node)
+    {
+        this->Dispatch(node);
+        TraverseChildren(node);
+    }
+
+    void TraverseChildren(ASTNode* node)
+    {
+        switch (node->kind)
+        {
+        case ASTNodeKind::TranslationUnit:
+        {
+            auto unit = static_cast<TranslationUnit*>(node);
+            if (unit->rootModule)
+                this->derived().Traverse(unit->rootModule);
+            break;
+        }
+
+        case ASTNodeKind::ModuleDefinition:
+        {
+            auto mod = static_cast<ModuleDefinition*>(node);
+
+            for (auto var : mod->variables)
+                this->derived().Traverse(var);
+
+            for (auto func : mod->functions)
+                this->derived().Traverse(func);
+
+            for (auto nested : mod->modules)
+                this->derived().Traverse(nested);
+            break;
+        }
+
+        case ASTNodeKind::FunctionDefinition:
+        {
+            auto func = static_cast<FunctionDefinition*>(node);
+
+            for (auto param : func->params)
+                this->derived().Traverse(param);
+
+            if (auto body = func->GetBody())
+                this->derived().Traverse(body);
+            break;
+        }
+
+        case ASTNodeKind::VariableDeclaration:
+        {
+            auto var = static_cast<VariableDeclaration*>(node);
+            if (var->initializer)
+                this->derived().Traverse(var->initializer);
+            break;
+        }
+
+        case ASTNodeKind::BlockStatement:
+            for (auto stmt : static_cast<BlockStatement*>(node)->statements)
+                this->derived().Traverse(stmt);
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto decl = static_cast<DeclarationStatement*>(node)->variableDeclaration;
+            if (decl)
+                this->derived().Traverse(decl);
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+        {
+            auto exp = static_cast<ExpressionStatement*>(node)->expression;
+            if (exp)
+                this->derived().Traverse(exp);
+            break;
+        }
+
+        case ASTNodeKind::ReturnStatement:
+        {
+            auto exp = static_cast<ReturnStatement*>(node)->expression;
+            if (exp)
+                this->derived().Traverse(exp);
+            break;
+        }
+
+        case ASTNodeKind::BinaryExpression:
+        {
+            auto bin = static_cast<BinaryExpression*>(node);
+            this->derived().Traverse(bin->left);
+            this->derived().Traverse(bin->right);
+            break;
+        }
+
+        case ASTNodeKind::FunctionExpression:
+            for (auto arg : static_cast<FunctionExpression*>(node)->arguments)
+                this->derived().Traverse(arg);
+            break;
+
+        default:
+            break;
+        }
+    }
+};
@@ -0,0 +1,164 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <ostream>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+// Interned name. Two symbols with the same text always have the same id,
+// so comparing names is an integer compare. Id 0 is the empty name.
+struct Symbol
+{
+    uint32_t id = 0;
+
+    Symbol() = default;
+
+    explicit Symbol(uint32_t id)
+        : id(id) {}
+
+    static Symbol Intern(std::string_view text);
+
+    std::string_view str() const;
+
+    bool empty() const {
+        return id == 0;
+    }
+
+    bool operator==(Symbol other) const {
+        return id == other.id;
+    }
+
+    bool operator!=(Symbol other) const {
+        return id != other.id;
+    }
+
+    bool operator<(Symbol other) const {
+        return id < other.id;
+    }
+};
+
+namespace std
+{
+    template<>
+    struct hash<Symbol>
+    {
+        size_t operator()(Symbol sym) const {
+            return std::hash<uint32_t>()(sym.id);
+        }
+    };
+}
+
+// Thread-safe string interner that hands out dense 32 bit symbol ids.
+// Interned text is never freed or moved, so views returned by GetString stay valid.
+class SymbolTable
+{
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::string_view> strings;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* block = nullptr;
+    size_t blockUsed = BlockSize;
+
+public:
+    SymbolTable()
+    {
+        strings.push_back(std::string_view());
+        ids.emplace(std::string_view(), 0);
+    }
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // table shared by the lexer, the AST and later passes
+    static SymbolTable& Global()
+    {
+        static SymbolTable table;
+        return table;
+    }
+
+    Symbol Intern(std::string_view text)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = ids.find(text);
+            if (it != ids.end())
+                return Symbol(it->second);
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+
+        // another thread may have added it between the locks
+        auto it = ids.find(text);
+        if (it != ids.end())
+            return Symbol(it->second);
+
+        auto stored = Store(text);
+        auto id = (uint32_t)strings.size();
+        strings.push_back(stored);
+        ids.emplace(stored, id);
+        return Symbol(id);
+    }
+
+    std::string_view GetString(Symbol sym) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        assert(sym.id < strings.size());
+        return strings[sym.id];
+    }
+
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return strings.size();
+    }
+
+private:
+
+    std::string_view Store(std::string_view text)
+    {
+        // long names get a block of their own instead of wasting the current one
+        if (text.size() > BlockSize / 4)
+        {
+            blocks.emplace_back(new char[text.size()]);
+            memcpy(blocks.back().get(), text.data(), text.size());
+            return std::string_view(blocks.back().get(), text.size());
+        }
+
+        if (BlockSize - blockUsed < text.size())
+        {
+            blocks.emplace_back(new char[BlockSize]);
+            block = blocks.back().get();
+            blockUsed = 0;
+        }
+
+        char* dst = block + blockUsed;
+        memcpy(dst, text.data(), text.size());
+        blockUsed += text.size();
+        return std::string_view(dst, text.size());
+    }
+};
+
+inline Symbol Symbol::Intern(std::string_view text) {
+    return SymbolTable::Global().Intern(text);
+}
+
+inline std::string_view Symbol::str() const {
+    return SymbolTable::Global().GetString(*this);
+}
+
+inline std::ostream& operator<<(std::ostream& stream, Symbol sym) {
+    return stream << sym.str();
+}
@@ -0,0 +1,219 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include "Pointers.h"
+
+// Fixed set of worker threads that run batches of independent, numbered tasks.
+// A batch starts out split evenly between the workers, and a worker that runs out of tasks steals
+// the back half of the remaining tasks of another, so uneven tasks still keep every worker busy.
+// The thread that calls ForEach works on the batch too, as worker 0.
+class ThreadPool
+{
+    // the tasks a worker hasn't started yet. the owner takes them from the front, thieves from the back.
+    struct Queue
+    {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> threads;
+    uptr<Queue[]> queues;
+    size_t workerCount;
+
+    std::mutex batchMutex;
+    std::mutex mutex;
+    std::condition_variable batchReady;
+    std::condition_variable batchDone;
+    const std::function<void(size_t, size_t)>* task = nullptr;
+    uint64_t generation = 0;
+    size_t busyThreads = 0;
+    bool stopping = false;
+
+    // the lowest numbered task that threw, and what it threw
+    std::mutex failureMutex;
+    std::atomic<size_t> failedTask { SIZE_MAX };
+    std::exception_ptr failure;
+
+public:
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency())
+        : workerCount(std::max<size_t>(threadCount, 1))
+    {
+        queues.reset(new Queue[workerCount]);
+
+        for (size_t i = 1; i < workerCount; ++i)
+            threads.emplace_back([this, i] { WorkerLoop(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        batchReady.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    // number of workers, including the calling thread
+    size_t size() const {
+        return workerCount;
+    }
+
+    // Calls fn(task, worker) for every task in [0, count), and returns when all are done.
+    // 'worker' is below size(), and no two calls with the same worker overlap, so it can index
+    // per-worker state. If tasks throw, the exception of the lowest numbered one is rethrown,
+    // and tasks numbered above it may be skipped. Tasks can't start batches of their own.
+    void ForEach(size_t count, const std::function<void(size_t, size_t)>& fn)
+    {
+        if (count == 0)
+            return;
+
+        std::lock_guard<std::mutex> batchLock(batchMutex);
+
+        for (size_t i = 0; i < workerCount; ++i)
+        {
+            std::lock_guard<std::mutex> lock(queues[i].mutex);
+            queues[i].begin = count * i / workerCount;
+            queues[i].end = count * (i + 1) / workerCount;
+        }
+
+        failedTask = SIZE_MAX;
+        failure = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            busyThreads = threads.size();
+            ++generation;
+        }
+
+        batchReady.notify_all();
+
+        RunTasks(0);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            batchDone.wait(lock, [this] { return busyThreads == 0; });
+            task = nullptr;
+        }
+
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+
+private:
+
+    void WorkerLoop(size_t worker)
+    {
+        uint64_t lastGeneration = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                batchReady.wait(lock, [&] { return stopping || generation != lastGeneration; });
+
+                if (stopping)
+                    return;
+
+                lastGeneration = generation;
+            }
+
+            RunTasks(worker);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busyThreads == 0)
+                    batchDone.notify_all();
+            }
+        }
+    }
+
+    void RunTasks(size_t worker)
+    {
+        size_t index;
+
+        while (Take(worker, index) || Steal(worker, index))
+        {
+            if (index > failedTask)
+                continue;
+
+            try {
+                (*task)(index, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+
+                if (index < failedTask) {
+                    failedTask = index;
+                    failure = std::current_exception();
+                }
+            }
+        }
+    }
+
+    bool Take(size_t worker, size_t& index)
+    {
+        auto& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.begin == queue.end)
+            return false;
+
+        index = queue.begin++;
+        return true;
+    }
+
+    // moves the back half of another worker's tasks to this worker's (empty) queue, and takes the first
+    bool Steal(size_t worker, size_t& index)
+    {
+        for (size_t i = 1; i < workerCount; ++i)
+        {
+            auto& victim = queues[(worker + i) % workerCount];
+            size_t begin, end;
+
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+
+                if (victim.begin == victim.end)
+                    continue;
+
+                end = victim.end;
+                begin = end - (end - victim.begin + 1) / 2;
+                victim.end = begin;
+            }
+
+            auto& queue = queues[worker];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            assert(queue.begin == queue.end);
+
+            index = begin;
+            queue.begin = begin + 1;
+            queue.end = end;
+            return true;
+        }
+
+        return false;
+    }
+};
@@ -0,0 +1,80 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include "TokenType.h"
+#include "Symbol.h"
+
+struct Token
+{
+    // location of a token's text in the source buffer
+    struct TextRange {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    union ValueType {
+        int64_t intValue;
+        double floatValue;
+        bool boolValue;
+        char charValue;
+        Symbol symbol;  // identifiers
+        TextRange text; // string literals
+    };
+
+    TokenType type = TokenType::EndOfFile;
+    bool escaped = false; // string literal contains escape sequences
+    size_t pos = -1;
+    ValueType storage = {};
+
+    Token() = default;
+
+    Token(TokenType type, size_t pos, TextRange text, bool escaped = false)
+        : type(type), escaped(escaped), pos(pos)
+    {
+        storage.text = text;
+    }
+
+    Token(TokenType type, size_t pos, Symbol symbol)
+        : type(type), pos(pos)
+    {
+        storage.symbol = symbol;
+    }
+
+    Token(TokenType type, size_t pos, int64_t value)
+        : type(type), pos(pos)
+    {
+        storage.intValue = value;
+    }
+
+    Token(TokenType type, size_t pos, double value)
+        : type(type), pos(pos)
+    {
+        storage.floatValue = value;
+    }
+
+    Token(TokenType type, size_t pos, bool value)
+        : type(type), pos(pos)
+    {
+        storage.boolValue = value;
+    }
+
+    Token(TokenType type, size_t pos, char value)
+        : type(type), pos(pos)
+    {
+        storage.charValue = value;
+    }
+
+    Token(TokenType type, size_t pos, std::nullptr_t value)
+        : type(type), pos(pos)
+    {
+        storage.intValue = 0;
+    }
+};
+
+static_assert(std::is_trivially_copyable<Token>::value, "tokens must stay plain data");
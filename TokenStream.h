@@ -0,0 +1,189 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include "Pointers.h"
+#include "SourceBuffer.h"
+#include "Token.h"
+
+// Struct-of-arrays token storage: 1 byte of type, 4 bytes of position and 4 bytes of payload per token.
+// The payload is the value itself when it fits in 32 bits (symbols, booleans, punctuation characters),
+// otherwise an index into 'values' (integers, floats and string literal ranges).
+class TokenStream
+{
+    // set in the payload of string tokens that contain escape sequences
+    static constexpr uint32_t EscapedBit = 0x80000000u;
+
+    sptr<SourceBuffer> source;
+    std::vector<TokenType> types;
+    std::vector<uint32_t> positions;
+    std::vector<uint32_t> payloads;
+    std::vector<Token::ValueType> values;
+
+public:
+    TokenStream() = default;
+
+    explicit TokenStream(const sptr<SourceBuffer>& source)
+        : source(source)
+    {
+    }
+
+    const sptr<SourceBuffer>& getSource() const {
+        return source;
+    }
+
+    size_t size() const {
+        return types.size();
+    }
+
+    bool empty() const {
+        return types.empty();
+    }
+
+    void Reserve(size_t tokenCount)
+    {
+        types.reserve(tokenCount);
+        positions.reserve(tokenCount);
+        payloads.reserve(tokenCount);
+        values.reserve(tokenCount / 8);
+    }
+
+    // reserves space for the tokens of a source of 'sourceSize' bytes.
+    // typical code averages a token every 4-6 bytes, so this rarely needs to grow.
+    void ReserveForSource(size_t sourceSize) {
+        Reserve(sourceSize / 4 + 16);
+    }
+
+    void Clear()
+    {
+        types.clear();
+        positions.clear();
+        payloads.clear();
+        values.clear();
+    }
+
+    void Append(const Token& token)
+    {
+        assert(token.pos <= UINT32_MAX);
+
+        types.push_back(token.type);
+        positions.push_back((uint32_t)token.pos);
+
+        switch (token.type)
+        {
+        case TokenType::Identifier:
+            payloads.push_back(token.storage.symbol.id);
+            break;
+
+        case TokenType::Boolean:
+            payloads.push_back(token.storage.boolValue ? 1 : 0);
+            break;
+
+        case TokenType::Integer:
+        case TokenType::Float:
+        case TokenType::String:
+            assert(values.size() < EscapedBit);
+            payloads.push_back((uint32_t)values.size() | (token.escaped ? EscapedBit : 0));
+            values.push_back(token.storage);
+            break;
+
+        default:
+            payloads.push_back((uint8_t)token.storage.charValue);
+            break;
+        }
+    }
+
+    // appends the tokens of 'other' from 'first' on. both streams must be over the same source.
+    void Append(const TokenStream& other, size_t first = 0)
+    {
+        assert(other.source == source && first <= other.size());
+
+        // values are stored in token order, so the ones that are needed are a suffix
+        size_t firstValue = other.values.size();
+
+        for (size_t i = first; i < other.size(); ++i)
+        {
+            if (HasValue(other.types[i])) {
+                firstValue = other.payloads[i] & ~EscapedBit;
+                break;
+            }
+        }
+
+        auto rebase = (uint32_t)values.size() - (uint32_t)firstValue;
+        assert(values.size() + (other.values.size() - firstValue) < EscapedBit);
+
+        types.insert(types.end(), other.types.begin() + first, other.types.end());
+        positions.insert(positions.end(), other.positions.begin() + first, other.positions.end());
+        values.insert(values.end(), other.values.begin() + firstValue, other.values.end());
+
+        for (size_t i = first; i < other.size(); ++i)
+        {
+            auto payload = other.payloads[i];
+
+            if (HasValue(other.types[i]))
+                payload = (payload & EscapedBit) | ((payload & ~EscapedBit) + rebase);
+
+            payloads.push_back(payload);
+        }
+    }
+
+    TokenType type(size_t index) const {
+        assert(index < types.size());
+        return types[index];
+    }
+
+    size_t position(size_t index) const {
+        assert(index < positions.size());
+        return positions[index];
+    }
+
+    // index of the first token at or after source offset 'pos', or size() if there is none
+    size_t Find(size_t pos) const {
+        return std::lower_bound(positions.begin(), positions.end(), pos) - positions.begin();
+    }
+
+    Token operator[](size_t index) const
+    {
+        assert(index < types.size());
+
+        auto type = types[index];
+        auto pos = positions[index];
+        auto payload = payloads[index];
+
+        switch (type)
+        {
+        case TokenType::Identifier:
+            return Token(type, pos, Symbol(payload));
+
+        case TokenType::Boolean:
+            return Token(type, pos, payload != 0);
+
+        case TokenType::Integer:
+        case TokenType::Float:
+        case TokenType::String:
+        {
+            Token token;
+            token.type = type;
+            token.pos = pos;
+            token.escaped = (payload & EscapedBit) != 0;
+            token.storage = values[payload & ~EscapedBit];
+            return token;
+        }
+
+        default:
+            return Token(type, pos, (char)payload);
+        }
+    }
+
+private:
+
+    static bool HasValue(TokenType type) {
+        return type == TokenType::Integer || type == TokenType::Float || type == TokenType::String;
+    }
+};
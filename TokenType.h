@@ -0,0 +1,36 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+
+enum class TokenType : int8_t
+{
+    Invalid = -1, // invalid 
+    EndOfFile,    // EOF
+    LeftCurly,    // {
+    RightCurly,   // }
+    LeftBracket,  // [
+    RightBracket, // ]
+    LeftParen,    // (
+    RightParen,   // )
+    Equals,       // =
+    Plus,         // +
+    Minus,        // -
+    Multiply,     // *
+    Divide,       // /
+    Dot,          // .
+    Comma,        // ,
+    Colon,        // :
+    Semicolon,    // ;
+    String,       // "abcd1234"
+    Integer,      // 123
+    Float,        // 12.34
+    Boolean,      // true false
+    Null,         // null
+    Identifier,   // _asdf3423
+    Module,       // module
+    Return,       // return
+};
@@ -7,6 +7,8 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include "Pointers.h"
+#include "Arena.h"
 #include "ModuleDefinition.h"
 #include "ASTNode.h"
 
@@ -14,7 +16,23 @@ class TranslationUnit : public ASTNode
 {
 public:
     std::string filename;
-    sptr<ModuleDefinition> rootModule;
+
+    // owns every node of the tree, which is released all at once with the translation unit
+    Arena arena;
+    ModuleDefinition* rootModule = nullptr;
+
+    // function bodies that were parsed in parallel are in the arenas of the threads that parsed them
+    std::vector<uptr<Arena>> workerArenas;
+
+    // parses function bodies that were skipped, when they're first used
+    uptr<FunctionBodyParser> bodyParser;
+
+    TranslationUnit()
+        : ASTNode(ASTNodeKind::TranslationUnit) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
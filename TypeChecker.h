@@ -0,0 +1,408 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "TypeTable.h"
+#include "NameResolver.h"
+#include "TranslationUnit.h"
+#include "ModuleDefinition.h"
+#include "FunctionDefinition.h"
+#include "FunctionParameter.h"
+#include "VariableDeclaration.h"
+#include "BlockStatement.h"
+#include "DeclarationStatement.h"
+#include "ExpressionStatement.h"
+#include "ReturnStatement.h"
+#include "BinaryExpression.h"
+#include "FunctionExpression.h"
+#include "IntegerExpression.h"
+#include "VariableExpression.h"
+
+// Gives every expression, declaration and function of a translation unit its type from a
+// TypeTable, and checks that they fit together:
+//  - declared types exist, and only functions return void
+//  - initializers have the type of their variable
+//  - both operands of an arithmetic operator are int, or both are float
+//  - calls pass as many arguments as the function has parameters, of the same types
+//  - return statements return the function's return type, or nothing from a void function
+//
+// Runs after NameResolver. Variables are found through the (depth, slot) pairs it assigned,
+// whose types are kept in one array per depth, so no names are looked up here either.
+class TypeChecker
+{
+    TypeTable& types;
+
+    // types of the variables in scope, by depth and slot
+    std::vector<std::vector<TypeId>> frames;
+
+    // types of the functions, by NameResolver's function index
+    std::vector<TypeId> functionTypes;
+
+    std::vector<ModuleDefinition*> modulePath;
+    FunctionDefinition* currentFunction = nullptr;
+    TypeId returnType = TypeTable::Error;
+
+    struct PendingExpression
+    {
+        Expression* expression;
+        bool childrenChecked;
+    };
+
+    std::vector<PendingExpression> pending;
+    std::vector<TypeId> parameters;
+    std::vector<std::string> errorList;
+
+public:
+    explicit TypeChecker(TypeTable& types)
+        : types(types) {}
+
+    // checks 'unit', whose names were resolved by 'names'. returns false if there were type
+    // errors, which errors() describes. everything that could be typed is annotated anyway.
+    bool Check(TranslationUnit& unit, const NameResolver& names)
+    {
+        static_assert(NameResolver::BuiltinCount == 1, "every builtin needs a type below");
+
+        errorList.clear();
+        frames.clear();
+        functionTypes.assign(std::max<size_t>(names.functions().size(), NameResolver::BuiltinCount), TypeTable::Error);
+
+        // print(int)
+        functionTypes[0] = types.GetFunction(TypeTable::Void, { TypeTable::Int });
+
+        if (unit.rootModule)
+            CheckModule(unit.rootModule, 0);
+
+        return errorList.empty();
+    }
+
+    const std::vector<std::string>& errors() const {
+        return errorList;
+    }
+
+private:
+
+    // the type called 'name', or Error after reporting it
+    TypeId ResolveType(Symbol name)
+    {
+        auto type = types.Find(name);
+
+        if (type == TypeTable::Error)
+            Error("unknown type '" + std::string(name.str()) + "'");
+
+        return type;
+    }
+
+    TypeId ResolveVariableType(Symbol typeName, Symbol name)
+    {
+        auto type = ResolveType(typeName);
+
+        if (type == TypeTable::Void) {
+            Error("variable '" + std::string(name.str()) + "' declared void");
+            type = TypeTable::Error;
+        }
+
+        return type;
+    }
+
+    std::vector<TypeId>& GetFrame(uint32_t depth)
+    {
+        if (depth >= frames.size())
+            frames.resize(depth + 1);
+
+        return frames[depth];
+    }
+
+    void CheckModule(ModuleDefinition* mod, uint32_t depth)
+    {
+        modulePath.push_back(mod);
+
+        // types first, since everything in the module can use everything else in it
+        auto& frame = GetFrame(depth);
+        frame.resize(mod->variables.size());
+
+        for (uint32_t i = 0; i < mod->variables.size(); ++i)
+        {
+            auto var = mod->variables[i];
+            var->type = ResolveVariableType(var->typeName, var->id);
+            frame[i] = var->type;
+        }
+
+        for (auto func : mod->functions)
+            CheckSignature(func);
+
+        for (auto var : mod->variables)
+            CheckInitializer(var);
+
+        for (auto func : mod->functions)
+            CheckFunction(func, depth + 1);
+
+        for (auto nested : mod->modules)
+            CheckModule(nested, depth + 1);
+
+        modulePath.pop_back();
+    }
+
+    void CheckSignature(FunctionDefinition* func)
+    {
+        currentFunction = func;
+        parameters.clear();
+
+        for (auto param : func->params)
+        {
+            param->type = ResolveVariableType(param->typeName, param->id);
+            parameters.push_back(param->type);
+        }
+
+        func->type = types.GetFunction(ResolveType(func->returnTypeName), parameters);
+
+        if (func->index != FunctionDefinition::Unresolved)
+            functionTypes[func->index] = func->type;
+
+        currentFunction = nullptr;
+    }
+
+    void CheckFunction(FunctionDefinition* func, uint32_t depth)
+    {
+        currentFunction = func;
+        returnType = types.Get(func->type).returnType;
+
+        auto& frame = GetFrame(depth);
+        frame.assign(std::max<size_t>(func->frameSize, func->params.size()), TypeTable::Error);
+
+        for (uint32_t i = 0; i < func->params.size(); ++i)
+            frame[i] = func->params[i]->type;
+
+        if (auto body = func->GetBody())
+            CheckStatement(body);
+
+        currentFunction = nullptr;
+    }
+
+    void CheckStatement(Statement* stmt)
+    {
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement:
+            for (auto s : static_cast<BlockStatement*>(stmt)->statements)
+                CheckStatement(s);
+            break;
+
+        case ASTNodeKind::DeclarationStatement:
+        {
+            auto var = static_cast<DeclarationStatement*>(stmt)->variableDeclaration;
+            if (!var)
+                break;
+
+            var->type = ResolveVariableType(var->typeName, var->id);
+            CheckInitializer(var);
+
+            // slots are reused, so the type is only valid from here to the end of the block
+            if (var->depth != VariableDeclaration::Unresolved)
+            {
+                auto& frame = GetFrame(var->depth);
+                if (var->slot >= frame.size())
+                    frame.resize(var->slot + 1, TypeTable::Error);
+
+                frame[var->slot] = var->type;
+            }
+            break;
+        }
+
+        case ASTNodeKind::ExpressionStatement:
+            if (auto exp = static_cast<ExpressionStatement*>(stmt)->expression)
+                CheckExpression(exp);
+            break;
+
+        case ASTNodeKind::ReturnStatement:
+        {
+            auto value = static_cast<ReturnStatement*>(stmt)->expression;
+            auto type = HasValue(value) ? CheckExpression(value) : TypeTable::Void;
+
+            if (!Compatible(type, returnType))
+            {
+                if (returnType == TypeTable::Void)
+                    Error("returning a value from a function that returns void");
+                else if (type == TypeTable::Void)
+                    Error("missing return value in a function that returns " + types.GetName(returnType));
+                else
+                    Error("returning " + types.GetName(type) + " from a function that returns " + types.GetName(returnType));
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    void CheckInitializer(VariableDeclaration* var)
+    {
+        if (!HasValue(var->initializer)) {
+            if (var->initializer)
+                var->initializer->type = TypeTable::Void;
+            return;
+        }
+
+        auto type = CheckExpression(var->initializer);
+
+        if (!Compatible(type, var->type)) {
+            Error("initializing '" + std::string(var->id.str()) + "' of type " + types.GetName(var->type) +
+                  " with " + types.GetName(type));
+        }
+    }
+
+    // types every expression under 'root', children before parents. iterative, since
+    // expressions can nest deeper than the stack allows.
+    TypeId CheckExpression(Expression* root)
+    {
+        pending.push_back(PendingExpression{ root, false });
+
+        while (!pending.empty())
+        {
+            auto item = pending.back();
+            auto exp = item.expression;
+
+            if (!item.childrenChecked)
+            {
+                pending.back().childrenChecked = true;
+
+                if (exp->kind == ASTNodeKind::BinaryExpression)
+                {
+                    auto bin = static_cast<BinaryExpression*>(exp);
+                    pending.push_back(PendingExpression{ bin->right, false });
+                    pending.push_back(PendingExpression{ bin->left, false });
+                }
+                else if (exp->kind == ASTNodeKind::FunctionExpression)
+                {
+                    auto& args = static_cast<FunctionExpression*>(exp)->arguments;
+                    for (auto i = args.size(); i-- > 0; )
+                        pending.push_back(PendingExpression{ args[i], false });
+                }
+
+                continue;
+            }
+
+            pending.pop_back();
+            exp->type = GetType(exp);
+        }
+
+        return root->type;
+    }
+
+    // type of 'exp', whose children are typed already
+    TypeId GetType(Expression* exp)
+    {
+        switch (exp->kind)
+        {
+        case ASTNodeKind::IntegerExpression:
+            return TypeTable::Int;
+
+        case ASTNodeKind::VariableExpression:
+        {
+            auto var = static_cast<VariableExpression*>(exp);
+            if (var->depth == VariableExpression::Unresolved)
+                return TypeTable::Error;
+
+            return frames[var->depth][var->slot];
+        }
+
+        case ASTNodeKind::BinaryExpression:
+        {
+            auto bin = static_cast<BinaryExpression*>(exp);
+            auto left = bin->left->type;
+            auto right = bin->right->type;
+
+            if (left == TypeTable::Error || right == TypeTable::Error)
+                return TypeTable::Error;
+
+            if (left != right || (left != TypeTable::Int && left != TypeTable::Float))
+            {
+                Error("invalid operands to '" + Lexer::GetTokenName(bin->operation) + "': " +
+                      types.GetName(left) + " and " + types.GetName(right));
+                return TypeTable::Error;
+            }
+
+            return left;
+        }
+
+        case ASTNodeKind::FunctionExpression:
+            return GetCallType(static_cast<FunctionExpression*>(exp));
+
+        default:
+            return TypeTable::Void;
+        }
+    }
+
+    TypeId GetCallType(FunctionExpression* call)
+    {
+        if (call->function == FunctionExpression::Unresolved)
+            return TypeTable::Error;
+
+        auto function = functionTypes[call->function];
+        if (function == TypeTable::Error)
+            return TypeTable::Error;
+
+        auto& signature = types.Get(function);
+        auto name = std::string(call->name.str());
+
+        if (call->arguments.size() != signature.parameterCount)
+        {
+            Error("'" + name + "' takes " + std::to_string(signature.parameterCount) + " arguments, not " +
+                  std::to_string(call->arguments.size()));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < signature.parameterCount; ++i)
+            {
+                auto argument = call->arguments[i]->type;
+                auto parameter = types.GetParameter(function, i);
+
+                if (!Compatible(argument, parameter)) {
+                    Error("argument " + std::to_string(i + 1) + " of '" + name + "' is " + types.GetName(argument) +
+                          ", not " + types.GetName(parameter));
+                }
+            }
+        }
+
+        // the call has the return type even if the arguments are wrong, so they're the only error
+        return signature.returnType;
+    }
+
+    // the parser represents a missing value with a plain Expression
+    static bool HasValue(Expression* exp) {
+        return exp && exp->kind != ASTNodeKind::Expression;
+    }
+
+    static bool Compatible(TypeId a, TypeId b) {
+        return a == b || a == TypeTable::Error || b == TypeTable::Error;
+    }
+
+    void Error(std::string message)
+    {
+        message += " in ";
+
+        // the root module is implicit, so it's left out of the path
+        std::string where;
+
+        for (size_t i = 1; i < modulePath.size(); ++i) {
+            if (!where.empty())
+                where += '.';
+            where += modulePath[i]->id.str();
+        }
+
+        if (currentFunction) {
+            if (!where.empty())
+                where += '.';
+            where += currentFunction->name.str();
+        }
+
+        message += where.empty() ? std::string("global scope") : where;
+        errorList.push_back(std::move(message));
+    }
+};
@@ -0,0 +1,165 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include "Symbol.h"
+
+// index of a type in a TypeTable
+using TypeId = uint32_t;
+
+enum class TypeKind : uint8_t
+{
+    Error,
+    Void,
+    Int,
+    Float,
+    Bool,
+    Function,
+};
+
+// Interned types. Every distinct type is stored once and named by a small integer, so comparing
+// two types is an integer compare and a type annotation costs four bytes. Function types are
+// interned by signature, so functions with the same return and parameter types share an id.
+class TypeTable
+{
+public:
+    // the builtin types always have these ids.
+    // Error is the type of whatever failed to check. It's compatible with every type, so a
+    // mistake is reported once instead of again by every expression that uses the result.
+    static constexpr TypeId Error = 0;
+    static constexpr TypeId Void = 1;
+    static constexpr TypeId Int = 2;
+    static constexpr TypeId Float = 3;
+    static constexpr TypeId Bool = 4;
+
+    struct Type
+    {
+        TypeKind kind;
+        TypeId returnType = Error;    // functions only
+        uint32_t firstParameter = 0;  // see GetParameter
+        uint32_t parameterCount = 0;
+    };
+
+private:
+    std::vector<Type> types;
+    std::vector<TypeId> parameterTypes;
+    std::vector<Symbol> names;
+    std::unordered_map<Symbol, TypeId> namedTypes;
+    std::unordered_map<std::string, TypeId> functionTypes;
+
+public:
+    TypeTable()
+    {
+        Type error;
+        error.kind = TypeKind::Error;
+        Add(error, Symbol::Intern("<error>"));
+
+        AddNamed(TypeKind::Void, "void");
+        AddNamed(TypeKind::Int, "int");
+        AddNamed(TypeKind::Float, "float");
+        AddNamed(TypeKind::Bool, "bool");
+    }
+
+    TypeTable(const TypeTable&) = delete;
+    TypeTable& operator=(const TypeTable&) = delete;
+
+    // the type called 'name', or Error if there isn't one
+    TypeId Find(Symbol name) const
+    {
+        auto it = namedTypes.find(name);
+        return it != namedTypes.end() ? it->second : Error;
+    }
+
+    // the type of functions that take 'parameters' and return 'returnType'
+    TypeId GetFunction(TypeId returnType, const std::vector<TypeId>& parameters)
+    {
+        // the signature's bytes are its key
+        std::string key(sizeof(TypeId) * (parameters.size() + 1), '\0');
+        memcpy(&key[0], &returnType, sizeof(TypeId));
+        if (!parameters.empty())
+            memcpy(&key[sizeof(TypeId)], parameters.data(), sizeof(TypeId) * parameters.size());
+
+        auto it = functionTypes.find(key);
+        if (it != functionTypes.end())
+            return it->second;
+
+        Type type;
+        type.kind = TypeKind::Function;
+        type.returnType = returnType;
+        type.firstParameter = (uint32_t)parameterTypes.size();
+        type.parameterCount = (uint32_t)parameters.size();
+        parameterTypes.insert(parameterTypes.end(), parameters.begin(), parameters.end());
+
+        auto id = Add(type, Symbol());
+        functionTypes.emplace(std::move(key), id);
+        return id;
+    }
+
+    const Type& Get(TypeId id) const
+    {
+        assert(id < types.size());
+        return types[id];
+    }
+
+    TypeKind GetKind(TypeId id) const {
+        return Get(id).kind;
+    }
+
+    TypeId GetParameter(TypeId function, uint32_t index) const
+    {
+        auto& type = Get(function);
+        assert(type.kind == TypeKind::Function && index < type.parameterCount);
+        return parameterTypes[type.firstParameter + index];
+    }
+
+    // spelling of the type for messages, like "int" or "int(int, float)"
+    std::string GetName(TypeId id) const
+    {
+        auto& type = Get(id);
+
+        if (type.kind != TypeKind::Function)
+            return std::string(names[id].str());
+
+        std::string ret = GetName(type.returnType) + "(";
+
+        for (uint32_t i = 0; i < type.parameterCount; ++i)
+        {
+            if (i != 0)
+                ret += ", ";
+            ret += GetName(parameterTypes[type.firstParameter + i]);
+        }
+
+        return ret + ")";
+    }
+
+    size_t size() const {
+        return types.size();
+    }
+
+private:
+
+    TypeId Add(const Type& type, Symbol name)
+    {
+        auto id = (TypeId)types.size();
+        types.push_back(type);
+        names.push_back(name);
+        return id;
+    }
+
+    void AddNamed(TypeKind kind, const char* name)
+    {
+        Type type;
+        type.kind = kind;
+
+        auto symbol = Symbol::Intern(name);
+        namedTypes.emplace(symbol, Add(type, symbol));
+    }
+};
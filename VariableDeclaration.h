@@ -4,16 +4,30 @@
 *--------------------------------------------------------------------------------------------*/
 
 #pragma once
-#include <string>
+#include "Symbol.h"
 #include "ASTNode.h"
 #include "Expression.h"
 
 class VariableDeclaration : public ASTNode
 {
 public:
-    std::string typeName;
-    std::string id;
-    sptr<Expression> initializer;
+    Symbol typeName;
+    Symbol id;
+    Expression* initializer = nullptr;
+
+    // where the variable is stored, set by NameResolver. see VariableExpression.
+    uint32_t depth = Unresolved;
+    uint32_t slot = Unresolved;
+
+    // the declared type, set by TypeChecker
+    TypeId type = TypeTable::Error;
+
+    VariableDeclaration()
+        : ASTNode(ASTNodeKind::VariableDeclaration) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
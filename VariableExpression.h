@@ -5,12 +5,24 @@
 
 #pragma once
 #include "Expression.h"
-#include <string>
+#include "Symbol.h"
 
 class VariableExpression : public Expression
 {
 public:
-    std::string name;
+    Symbol name;
+
+    // where the variable is stored: slot 'slot' of the scope 'depth' levels below the root module.
+    // set by NameResolver.
+    uint32_t depth = Unresolved;
+    uint32_t slot = Unresolved;
+
+    VariableExpression()
+        : Expression(ASTNodeKind::VariableExpression) {}
+
+    virtual void Accept(ASTVisitor* v) {
+        v->Visit(this);
+    }
 
     virtual void Print(std::stringstream& stream, int indent, int tabWidth)
     {
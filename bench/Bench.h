@@ -0,0 +1,174 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <random>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// Minimal timing helpers shared by the benchmarks in this directory.
+// Build a benchmark from this directory with, e.g.:
+//   g++ -O2 -std=c++17 -I.. -I../third_party/utfcpp-3.1 KeywordBench.cpp -o KeywordBench -lpthread
+
+// returns the fastest of 'runs' timings of 'fn', in seconds
+template<class F>
+double Measure(F&& fn, int runs = 5)
+{
+    double best = 1e30;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+// prints time per item and, if 'bytes' is nonzero, throughput
+inline void Report(const char* name, double seconds, size_t items, size_t bytes = 0)
+{
+    if (bytes != 0)
+        printf("%-32s %10.3f ms %10.2f ns/item %10.1f MB/s\n", name, seconds * 1e3, seconds * 1e9 / items, bytes / seconds / 1e6);
+    else
+        printf("%-32s %10.3f ms %10.2f ns/item\n", name, seconds * 1e3, seconds * 1e9 / items);
+}
+
+// peak resident set size of this process so far, in bytes
+inline size_t PeakMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// keeps the optimizer from discarding a computed value
+template<class T>
+void KeepAlive(const T& value)
+{
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+}
+
+inline std::mt19937& BenchRandom()
+{
+    static std::mt19937 rng(12345);
+    return rng;
+}
+
+inline std::string RandomIdentifier(size_t minLength = 2, size_t maxLength = 12)
+{
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+    auto& rng = BenchRandom();
+
+    size_t length = minLength + rng() % (maxLength - minLength + 1);
+    std::string ret(1, chars[rng() % 53]);
+
+    while (ret.size() < length)
+        ret += chars[rng() % 63];
+
+    return ret;
+}
+
+// at least 'size' bytes of modules of variables and small functions, the usual parsing workload
+inline std::string MakeModuleSource(size_t size)
+{
+    std::string text;
+    text.reserve(size + 4096);
+
+    while (text.size() < size)
+    {
+        text += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            text += "    int " + RandomIdentifier() + " = " + std::to_string(BenchRandom()() % 100000) + ";\n";
+            text += "    int " + RandomIdentifier() + "(int a, int b)\n    {\n";
+            text += "        int c = 4 - 3 * f(a) + 1 - 2 * b + 10;\n";
+            text += "        return c;\n";
+            text += "    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
+
+// expression of up to 'depth' levels of sums, products and calls over literals and names
+inline std::string RandomExpression(int depth)
+{
+    auto& rng = BenchRandom();
+
+    if (depth == 0 || rng() % 4 == 0)
+        return rng() % 2 ? std::to_string(rng() % 1000) : RandomIdentifier();
+
+    switch (rng() % 3)
+    {
+    case 0:
+        return RandomExpression(depth - 1) + " + " + RandomExpression(depth - 1);
+    case 1:
+        return "(" + RandomExpression(depth - 1) + ") * " + RandomExpression(depth - 1);
+    default:
+        return RandomIdentifier() + "(" + RandomExpression(depth - 1) + ", " + RandomExpression(depth - 1) + ")";
+    }
+}
+
+// at least 'size' bytes of functions whose bodies are mostly random expressions
+inline std::string MakeExpressionSource(size_t size)
+{
+    std::string text;
+
+    while (text.size() < size)
+    {
+        text += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            text += "    int " + RandomIdentifier() + "(int a, int b)\n    {\n";
+
+            for (int j = 0; j < 4; ++j)
+                text += "        int " + RandomIdentifier() + " = " + RandomExpression(6) + ";\n";
+
+            text += "        return " + RandomExpression(4) + ";\n    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
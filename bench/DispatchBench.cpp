@@ -0,0 +1,144 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Token dispatch: the hand-written switch that GetNextToken used to be, versus the
+// character class table and operator DFA from LexerTables.h. Both map the bytes at
+// each token start to a token type (or a class for tokens with a payload).
+
+#include <string>
+#include <vector>
+#include <cctype>
+#include "Bench.h"
+#include "../Lexer.h"
+
+enum { StartsString = 100, StartsNumber, StartsIdentifier };
+
+static int SwitchDispatch(const char* p, const char* end)
+{
+    switch (*p)
+    {
+    case '{': return (int)TokenType::LeftCurly;
+    case '}': return (int)TokenType::RightCurly;
+    case '[': return (int)TokenType::LeftBracket;
+    case ']': return (int)TokenType::RightBracket;
+    case '(': return (int)TokenType::LeftParen;
+    case ')': return (int)TokenType::RightParen;
+    case '=': return (int)TokenType::Equals;
+    case '+': return (int)TokenType::Plus;
+    case '-': return (int)TokenType::Minus;
+    case '*': return (int)TokenType::Multiply;
+    case '/': return (int)TokenType::Divide;
+    case ',': return (int)TokenType::Comma;
+    case ':': return (int)TokenType::Colon;
+    case ';': return (int)TokenType::Semicolon;
+    case '\"': return StartsString;
+    case '.':
+        if (p + 1 == end || !isdigit((unsigned char)p[1]))
+            return (int)TokenType::Dot;
+        // fall through
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return StartsNumber;
+    default:
+        if (isalpha((unsigned char)*p) || *p == '_')
+            return StartsIdentifier;
+        return (int)TokenType::Invalid;
+    }
+}
+
+static int TableDispatch(const char* p, const char* end)
+{
+    using namespace LexerTables;
+
+    switch (CharClasses[(unsigned char)*p])
+    {
+    case CharClass::Operator:
+    {
+        size_t state = 0;
+        auto type = TokenType::Invalid;
+
+        while (p != end && (state = Operator.next[state][(unsigned char)*p]) != 0) {
+            ++p;
+            if (Operator.accept[state] != TokenType::Invalid)
+                type = Operator.accept[state];
+            if (Operator.leaf[state])
+                break;
+        }
+
+        return (int)type;
+    }
+    case CharClass::DotOrNumber:
+        return (p + 1 != end && IsDigit(p[1])) ? StartsNumber : (int)TokenType::Dot;
+    case CharClass::String:
+        return StartsString;
+    case CharClass::Number:
+        return StartsNumber;
+    case CharClass::Identifier:
+    case CharClass::NonAscii:
+        return StartsIdentifier;
+    default:
+        return (int)TokenType::Invalid;
+    }
+}
+
+int main()
+{
+    // punctuation heavy source, so dispatch dominates
+    auto& rng = BenchRandom();
+    std::string source;
+
+    while (source.size() < 32 * 1024 * 1024)
+    {
+        source += "f(" + RandomIdentifier(1, 6) + ",(" + std::to_string(rng() % 100) + "+x)*y)-[a.b]/{c:d};";
+        if (rng() % 8 == 0)
+            source += "\"s\".5=";
+    }
+
+    auto buffer = SourceBuffer::FromMemory(source.data(), source.size());
+    std::vector<size_t> starts;
+    Lexer lexer(buffer);
+
+    for (auto tok = lexer.GetNextToken(); tok.type != TokenType::EndOfFile; tok = lexer.GetNextToken())
+        starts.push_back(tok.pos);
+
+    auto begin = source.data();
+    auto end = begin + source.size();
+
+    for (auto pos : starts)
+    {
+        if (SwitchDispatch(begin + pos, end) != TableDispatch(begin + pos, end)) {
+            printf("dispatch mismatch at %zu\n", pos);
+            return 1;
+        }
+    }
+
+    auto sw = Measure([&] {
+        int sum = 0;
+        for (auto pos : starts)
+            sum += SwitchDispatch(begin + pos, end);
+        KeepAlive(sum);
+    });
+
+    auto table = Measure([&] {
+        int sum = 0;
+        for (auto pos : starts)
+            sum += TableDispatch(begin + pos, end);
+        KeepAlive(sum);
+    });
+
+    Report("switch dispatch", sw, starts.size());
+    Report("table dispatch", table, starts.size());
+
+    auto lex = Measure([&] {
+        Lexer lexer(buffer);
+        size_t tokens = 0;
+        while (lexer.GetNextToken().type != TokenType::EndOfFile)
+            ++tokens;
+        KeepAlive(tokens);
+    }, 3);
+
+    Report("lexer, per token", lex, starts.size(), source.size());
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Expression parsing on pathological inputs: deeply nested parentheses and calls, which would
+// overflow the native stack of a recursive descent parser, and one very long operator chain.
+// Depth and length are 1M (or argv[1]) levels/operands.
+
+#include <string>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+
+static std::string Wrap(const std::string& expression) {
+    return "module m\n{\n    int f()\n    {\n        return " + expression + ";\n    }\n}\n";
+}
+
+static std::string NestedParens(size_t depth) {
+    return Wrap(std::string(depth, '(') + "1" + std::string(depth, ')'));
+}
+
+static std::string NestedCalls(size_t depth)
+{
+    std::string text;
+    text.reserve(depth * 6 + 16);
+
+    for (size_t i = 0; i < depth; ++i)
+        text += "f(1, ";
+
+    text += "x";
+    text += std::string(depth, ')');
+    return Wrap(text);
+}
+
+static std::string LongChain(size_t length)
+{
+    static const char operators[] = { '+', '-', '*', '/' };
+    std::string text = "1";
+    text.reserve(length * 8);
+
+    for (size_t i = 1; i < length; ++i)
+    {
+        text += ' ';
+        text += operators[i % 4];
+        text += ' ';
+        text += std::to_string(i % 1000);
+    }
+
+    return Wrap(text);
+}
+
+static void Run(const char* name, const std::string& text)
+{
+    auto source = SourceBuffer::FromMemory(text);
+    size_t tokenCount = Lexer::TokenizeStream(source).size();
+
+    auto seconds = Measure([&] {
+        Parser parser(source);
+        KeepAlive(parser.ParseTranslationUnit()->rootModule->modules.size());
+    }, 3);
+
+    Report(name, seconds, tokenCount, source->size());
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    Run("nested parentheses", NestedParens(count));
+    Run("nested calls", NestedCalls(count));
+    Run("long operator chain", LongChain(count));
+
+    printf("peak memory: %.1f MB\n", PeakMemory() / 1e6);
+    return 0;
+}
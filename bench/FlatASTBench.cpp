@@ -0,0 +1,180 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Whole-tree traversal of the pointer AST against the FlatAST built from it, on an expression
+// heavy source of 32 MB (or argv[1] MB). The tree walks fold the integer literals and names of every
+// expression into a checksum in the same order, so their results must match.
+
+#include <string>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+#include "../FlatAST.h"
+
+static uint64_t Mix(uint64_t sum, uint64_t value) {
+    return (sum ^ value) * 0x100000001B3ull;
+}
+
+// pointer tree
+
+static uint64_t Walk(const Expression* exp, uint64_t sum)
+{
+    switch (exp->kind)
+    {
+    case ASTNodeKind::BinaryExpression: {
+        auto bin = static_cast<const BinaryExpression*>(exp);
+        return Walk(bin->right, Walk(bin->left, sum));
+    }
+    case ASTNodeKind::FunctionExpression: {
+        auto func = static_cast<const FunctionExpression*>(exp);
+        sum = Mix(sum, func->name.id);
+        for (auto arg : func->arguments)
+            sum = Walk(arg, sum);
+        return sum;
+    }
+    case ASTNodeKind::IntegerExpression:
+        return Mix(sum, (uint64_t)static_cast<const IntegerExpression*>(exp)->value);
+    case ASTNodeKind::VariableExpression:
+        return Mix(sum, static_cast<const VariableExpression*>(exp)->name.id);
+    default:
+        return sum;
+    }
+}
+
+static uint64_t Walk(const Statement* stmt, uint64_t sum)
+{
+    switch (stmt->kind)
+    {
+    case ASTNodeKind::BlockStatement:
+        for (auto s : static_cast<const BlockStatement*>(stmt)->statements)
+            sum = Walk(s, sum);
+        return sum;
+    case ASTNodeKind::DeclarationStatement:
+        return Walk(static_cast<const DeclarationStatement*>(stmt)->variableDeclaration->initializer, sum);
+    case ASTNodeKind::ReturnStatement:
+        return Walk(static_cast<const ReturnStatement*>(stmt)->expression, sum);
+    case ASTNodeKind::ExpressionStatement:
+        return Walk(static_cast<const ExpressionStatement*>(stmt)->expression, sum);
+    default:
+        return sum;
+    }
+}
+
+static uint64_t Walk(const ModuleDefinition* mod, uint64_t sum)
+{
+    for (auto var : mod->variables)
+        sum = Walk(var->initializer, sum);
+
+    for (auto func : mod->functions)
+        sum = Walk(func->GetBody(), sum);
+
+    for (auto m : mod->modules)
+        sum = Walk(m, sum);
+
+    return sum;
+}
+
+// flat tree
+
+static uint64_t WalkExpression(const FlatAST& ast, FlatAST::Index index, uint64_t sum)
+{
+    auto& exp = ast.expressions[index];
+
+    switch (exp.kind)
+    {
+    case ASTNodeKind::BinaryExpression:
+        return WalkExpression(ast, exp.right(), WalkExpression(ast, exp.left(), sum));
+    case ASTNodeKind::FunctionExpression:
+        sum = Mix(sum, exp.name().id);
+        for (FlatAST::Index i = 0; i < exp.arguments().count; ++i)
+            sum = WalkExpression(ast, ast.child(exp.arguments(), i), sum);
+        return sum;
+    case ASTNodeKind::IntegerExpression:
+        return Mix(sum, (uint64_t)exp.value());
+    case ASTNodeKind::VariableExpression:
+        return Mix(sum, exp.name().id);
+    default:
+        return sum;
+    }
+}
+
+static uint64_t WalkStatement(const FlatAST& ast, FlatAST::Index index, uint64_t sum)
+{
+    auto& stmt = ast.statements[index];
+
+    switch (stmt.kind)
+    {
+    case ASTNodeKind::BlockStatement:
+        for (FlatAST::Index i = 0; i < stmt.statements().count; ++i)
+            sum = WalkStatement(ast, ast.child(stmt.statements(), i), sum);
+        return sum;
+    case ASTNodeKind::DeclarationStatement:
+        return WalkExpression(ast, ast.variables[stmt.variable()].initializer, sum);
+    case ASTNodeKind::ReturnStatement:
+    case ASTNodeKind::ExpressionStatement:
+        return WalkExpression(ast, stmt.expression(), sum);
+    default:
+        return sum;
+    }
+}
+
+static uint64_t WalkModule(const FlatAST& ast, FlatAST::Index index, uint64_t sum)
+{
+    auto& mod = ast.modules[index];
+
+    for (FlatAST::Index i = 0; i < mod.variables.count; ++i)
+        sum = WalkExpression(ast, ast.variables[ast.child(mod.variables, i)].initializer, sum);
+
+    for (FlatAST::Index i = 0; i < mod.functions.count; ++i)
+        sum = WalkStatement(ast, ast.functions[ast.child(mod.functions, i)].body, sum);
+
+    for (FlatAST::Index i = 0; i < mod.modules.count; ++i)
+        sum = WalkModule(ast, ast.child(mod.modules, i), sum);
+
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 32) << 20;
+    auto source = SourceBuffer::FromMemory(MakeExpressionSource(size));
+
+    Parser parser(source);
+    auto unit = parser.ParseTranslationUnit();
+
+    FlatAST flat;
+    auto convert = Measure([&] { flat = FlatAST::FromTree(*unit); }, 3);
+    size_t count = flat.expressions.size();
+
+    uint64_t treeSum = 0, flatSum = 0, scanSum = 0;
+
+    auto tree = Measure([&] { treeSum = Walk(unit->rootModule, 0); });
+    auto flatWalk = Measure([&] { flatSum = WalkModule(flat, flat.rootModule, 0); });
+
+    // passes that don't care about tree order can just scan the array
+    auto scan = Measure([&] {
+        scanSum = 0;
+        for (auto& exp : flat.expressions)
+        {
+            if (exp.kind == ASTNodeKind::IntegerExpression)
+                scanSum += (uint64_t)exp.value();
+            else if (exp.kind == ASTNodeKind::VariableExpression || exp.kind == ASTNodeKind::FunctionExpression)
+                scanSum += exp.name().id;
+        }
+    });
+
+    KeepAlive(scanSum);
+
+    printf("%zu expressions, arena %.1f MB, flat expressions, statements and children %.1f MB\n", count, unit->arena.size() / 1e6,
+           (flat.expressions.size() * sizeof(FlatAST::Expr) + flat.statements.size() * sizeof(FlatAST::Stmt) +
+            flat.children.size() * sizeof(FlatAST::Index)) / 1e6);
+
+    Report("convert to FlatAST", convert, count);
+    Report("pointer tree walk", tree, count);
+    Report("flat tree walk", flatWalk, count);
+    Report("flat linear scan", scan, count);
+    printf("tree walk checksums %s\n", treeSum == flatSum ? "match" : "DIFFER");
+    return 0;
+}
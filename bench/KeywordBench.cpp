@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Per-identifier cost of keyword recognition: the old approach of building a std::string
+// and comparing it against each keyword in the parser, versus the compile-time perfect hash.
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "Bench.h"
+#include "../Lexer.h"
+
+int main()
+{
+    const size_t count = 2000000;
+    std::vector<std::string> words;
+    words.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // roughly one in eight identifiers is a keyword
+        if (i % 8 == 0)
+            words.push_back(std::string(Keywords::List[i / 8 % Keywords::Count].text));
+        else
+            words.push_back(RandomIdentifier());
+    }
+
+    const std::unordered_set<std::string> keywordSet = { "module", "return", "true", "false", "null" };
+
+    auto compare = Measure([&] {
+        size_t found = 0;
+        for (auto& w : words) {
+            std::string id(w.data(), w.size());
+            found += id == "module" || id == "return" || id == "true" || id == "false" || id == "null";
+        }
+        KeepAlive(found);
+    });
+
+    auto set = Measure([&] {
+        size_t found = 0;
+        for (auto& w : words)
+            found += keywordSet.count(w);
+        KeepAlive(found);
+    });
+
+    auto hash = Measure([&] {
+        size_t found = 0;
+        for (auto& w : words)
+            found += Keywords::Find(w.data(), w.size()) != nullptr;
+        KeepAlive(found);
+    });
+
+    Report("string compares", compare, count);
+    Report("unordered_set lookup", set, count);
+    Report("perfect hash", hash, count);
+
+    // whole-lexer cost per identifier, keywords included
+    std::string source;
+    for (auto& w : words) {
+        source += w;
+        source += ' ';
+    }
+
+    auto buffer = SourceBuffer::FromMemory(source.data(), source.size());
+    
+    auto lex = Measure([&] {
+        Lexer lexer(buffer);
+        size_t tokens = 0;
+        while (lexer.GetNextToken().type != TokenType::EndOfFile)
+            ++tokens;
+        KeepAlive(tokens);
+    });
+
+    Report("lexer, per identifier", lex, count, source.size());
+    return 0;
+}
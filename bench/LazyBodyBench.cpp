@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// A signature-only pass (counting every function's parameters) over a full parse against one
+// that skips function bodies, on a 64 MB (or argv[1] MB) source, both fused with the lexer and
+// from a pre-tokenized stream.
+
+#include <string>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+
+static std::string MakeSource(size_t size)
+{
+    std::string text;
+    text.reserve(size + 4096);
+
+    while (text.size() < size)
+    {
+        text += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            text += "    int " + RandomIdentifier() + "(int a, int b)\n    {\n";
+            text += "        int c = 4 - 3 * f(a) + 1 - 2 * b + 10;\n";
+            text += "        int d = (c + a) * (c - b) / g(c, a, b);\n";
+            text += "        {\n";
+            text += "            int e = h(d * 2, c) - a * (b + 1);\n";
+            text += "        }\n";
+            text += "        return c + d;\n";
+            text += "    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
+
+static size_t CountParameters(const ModuleDefinition* mod)
+{
+    size_t count = 0;
+
+    for (auto func : mod->functions)
+        count += func->params.size();
+
+    for (auto nested : mod->modules)
+        count += CountParameters(nested);
+
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 64) << 20;
+    auto source = SourceBuffer::FromMemory(MakeSource(size));
+    auto tokens = Lexer::TokenizeStream(source);
+
+    auto run = [&](Parser&& parser, bool lazy) {
+        parser.SetLazyFunctionBodies(lazy);
+        KeepAlive(CountParameters(parser.ParseTranslationUnit()->rootModule));
+    };
+
+    auto fusedFull = Measure([&] { run(Parser(source), false); }, 3);
+    auto fusedLazy = Measure([&] { run(Parser(source), true); }, 3);
+    auto streamFull = Measure([&] { run(Parser(tokens), false); }, 3);
+    auto streamLazy = Measure([&] { run(Parser(tokens), true); }, 3);
+
+    Report("fused, full parse", fusedFull, tokens.size(), source->size());
+    Report("fused, bodies skipped", fusedLazy, tokens.size(), source->size());
+    Report("token stream, full parse", streamFull, tokens.size(), source->size());
+    Report("token stream, bodies skipped", streamLazy, tokens.size(), source->size());
+    return 0;
+}
@@ -0,0 +1,297 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Name resolution over large modules (argv[1] modules of 4000 variables and 1000 functions,
+// 16 by default): NameResolver's flat binding stack against a chain of hash maps, one per
+// scope. Both must resolve every name to the same place.
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+#include "../NameResolver.h"
+
+static const int VariablesPerModule = 4000;
+static const int FunctionsPerModule = 1000;
+
+static std::string MakeSource(int moduleCount)
+{
+    auto& rng = BenchRandom();
+    std::string text;
+
+    auto moduleVariable = [&] { return "v" + std::to_string(rng() % VariablesPerModule); };
+    auto function = [&] { return "f" + std::to_string(rng() % FunctionsPerModule); };
+
+    for (int m = 0; m < moduleCount; ++m)
+    {
+        text += "module m" + std::to_string(m) + "\n{\n";
+
+        for (int i = 0; i < VariablesPerModule; ++i)
+            text += "    int v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+
+        for (int i = 0; i < FunctionsPerModule; ++i)
+        {
+            text += "    int f" + std::to_string(i) + "(int a, int b)\n    {\n";
+            text += "        int l0 = a + " + moduleVariable() + ";\n";
+
+            for (int j = 1; j < 6; ++j)
+            {
+                auto local = "l" + std::to_string(rng() % j);
+                text += "        int l" + std::to_string(j) + " = " + local + " * " + moduleVariable() + " + " + function() + "(b, " + local + ");\n";
+            }
+
+            text += "        {\n            int l0 = l5 + b;\n            print(l0);\n        }\n";
+            text += "        return l0 + " + moduleVariable() + ";\n    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
+
+// the same rules through a chain of maps
+
+class MapResolver
+{
+    struct Place { uint32_t depth, slot; };
+
+    std::vector<std::unordered_map<uint32_t, Place>> variableScopes;
+    std::vector<std::unordered_map<uint32_t, uint32_t>> functionScopes;
+    uint32_t frameStart = 0, frameUsed = 0;
+    std::vector<uint32_t> blockUsed;
+    std::vector<FunctionDefinition*> functions;
+
+public:
+    size_t resolved = 0;
+    uint64_t checksum = 0;
+
+    void Resolve(TranslationUnit& unit)
+    {
+        functionScopes.emplace_back();
+        for (uint32_t i = 0; i < NameResolver::BuiltinCount; ++i) {
+            functionScopes.back()[Symbol::Intern(NameResolver::BuiltinNames[i]).id] = i;
+            functions.push_back(nullptr);
+        }
+
+        ResolveModule(unit.rootModule, 0);
+    }
+
+private:
+    void Note(uint32_t depth, uint32_t slot) {
+        ++resolved;
+        checksum = (checksum ^ ((uint64_t)depth << 32 | slot)) * 0x100000001B3ull;
+    }
+
+    const Place* FindVariable(Symbol name)
+    {
+        for (auto it = variableScopes.rbegin(); it != variableScopes.rend(); ++it) {
+            auto found = it->find(name.id);
+            if (found != it->end())
+                return &found->second;
+        }
+        return nullptr;
+    }
+
+    void ResolveModule(ModuleDefinition* mod, uint32_t depth)
+    {
+        variableScopes.emplace_back();
+        functionScopes.emplace_back();
+
+        for (uint32_t i = 0; i < mod->variables.size(); ++i)
+            variableScopes.back()[mod->variables[i]->id.id] = Place{ depth, i };
+
+        for (auto func : mod->functions) {
+            functionScopes.back()[func->name.id] = (uint32_t)functions.size();
+            functions.push_back(func);
+        }
+
+        for (auto var : mod->variables)
+            ResolveExpression(var->initializer);
+
+        for (auto func : mod->functions)
+        {
+            variableScopes.emplace_back();
+            frameUsed = (uint32_t)func->params.size();
+
+            for (uint32_t i = 0; i < func->params.size(); ++i)
+                variableScopes.back()[func->params[i]->id.id] = Place{ depth + 1, i };
+
+            for (auto stmt : static_cast<BlockStatement*>(func->GetBody())->statements)
+                ResolveStatement(stmt, depth + 1);
+
+            variableScopes.pop_back();
+        }
+
+        for (auto nested : mod->modules)
+            ResolveModule(nested, depth + 1);
+
+        variableScopes.pop_back();
+        functionScopes.pop_back();
+    }
+
+    void ResolveStatement(Statement* stmt, uint32_t depth)
+    {
+        switch (stmt->kind)
+        {
+        case ASTNodeKind::BlockStatement: {
+            auto used = frameUsed;
+            variableScopes.emplace_back();
+            for (auto s : static_cast<BlockStatement*>(stmt)->statements)
+                ResolveStatement(s, depth);
+            variableScopes.pop_back();
+            frameUsed = used;
+            break;
+        }
+        case ASTNodeKind::DeclarationStatement: {
+            auto var = static_cast<DeclarationStatement*>(stmt)->variableDeclaration;
+            ResolveExpression(var->initializer);
+            variableScopes.back()[var->id.id] = Place{ depth, frameUsed++ };
+            break;
+        }
+        case ASTNodeKind::ExpressionStatement:
+            ResolveExpression(static_cast<ExpressionStatement*>(stmt)->expression);
+            break;
+        case ASTNodeKind::ReturnStatement:
+            ResolveExpression(static_cast<ReturnStatement*>(stmt)->expression);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void ResolveExpression(Expression* exp)
+    {
+        switch (exp->kind)
+        {
+        case ASTNodeKind::VariableExpression:
+            if (auto place = FindVariable(static_cast<VariableExpression*>(exp)->name))
+                Note(place->depth, place->slot);
+            break;
+        case ASTNodeKind::FunctionExpression: {
+            auto call = static_cast<FunctionExpression*>(exp);
+            for (auto it = functionScopes.rbegin(); it != functionScopes.rend(); ++it) {
+                auto found = it->find(call->name.id);
+                if (found != it->end()) {
+                    Note(UINT32_MAX, found->second);
+                    break;
+                }
+            }
+            for (auto arg : call->arguments)
+                ResolveExpression(arg);
+            break;
+        }
+        case ASTNodeKind::BinaryExpression:
+            ResolveExpression(static_cast<BinaryExpression*>(exp)->left);
+            ResolveExpression(static_cast<BinaryExpression*>(exp)->right);
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+// folds what NameResolver stored in the tree in the order MapResolver visits it
+
+static void Fold(Expression* exp, size_t& resolved, uint64_t& checksum)
+{
+    auto note = [&](uint32_t depth, uint32_t slot) {
+        ++resolved;
+        checksum = (checksum ^ ((uint64_t)depth << 32 | slot)) * 0x100000001B3ull;
+    };
+
+    switch (exp->kind)
+    {
+    case ASTNodeKind::VariableExpression:
+        note(static_cast<VariableExpression*>(exp)->depth, static_cast<VariableExpression*>(exp)->slot);
+        break;
+    case ASTNodeKind::FunctionExpression:
+        note(UINT32_MAX, static_cast<FunctionExpression*>(exp)->function);
+        for (auto arg : static_cast<FunctionExpression*>(exp)->arguments)
+            Fold(arg, resolved, checksum);
+        break;
+    case ASTNodeKind::BinaryExpression:
+        Fold(static_cast<BinaryExpression*>(exp)->left, resolved, checksum);
+        Fold(static_cast<BinaryExpression*>(exp)->right, resolved, checksum);
+        break;
+    default:
+        break;
+    }
+}
+
+static void Fold(Statement* stmt, size_t& resolved, uint64_t& checksum)
+{
+    switch (stmt->kind)
+    {
+    case ASTNodeKind::BlockStatement:
+        for (auto s : static_cast<BlockStatement*>(stmt)->statements)
+            Fold(s, resolved, checksum);
+        break;
+    case ASTNodeKind::DeclarationStatement:
+        Fold(static_cast<DeclarationStatement*>(stmt)->variableDeclaration->initializer, resolved, checksum);
+        break;
+    case ASTNodeKind::ExpressionStatement:
+        Fold(static_cast<ExpressionStatement*>(stmt)->expression, resolved, checksum);
+        break;
+    case ASTNodeKind::ReturnStatement:
+        Fold(static_cast<ReturnStatement*>(stmt)->expression, resolved, checksum);
+        break;
+    default:
+        break;
+    }
+}
+
+static void Fold(ModuleDefinition* mod, size_t& resolved, uint64_t& checksum)
+{
+    for (auto var : mod->variables)
+        Fold(var->initializer, resolved, checksum);
+
+    for (auto func : mod->functions)
+        Fold(func->GetBody(), resolved, checksum);
+
+    for (auto nested : mod->modules)
+        Fold(nested, resolved, checksum);
+}
+
+int main(int argc, char** argv)
+{
+    int moduleCount = argc > 1 ? atoi(argv[1]) : 16;
+    auto source = SourceBuffer::FromMemory(MakeSource(moduleCount));
+
+    Parser parser(source);
+    auto unit = parser.ParseTranslationUnit();
+
+    // bodies are parsed on first use, which shouldn't be timed
+    bool ok = false;
+    NameResolver resolver;
+    auto flat = Measure([&] { ok = resolver.Resolve(*unit); });
+
+    size_t mapResolved = 0;
+    uint64_t mapChecksum = 0;
+
+    auto maps = Measure([&] {
+        MapResolver mapResolver;
+        mapResolver.Resolve(*unit);
+        mapResolved = mapResolver.resolved;
+        mapChecksum = mapResolver.checksum;
+    });
+
+    size_t resolved = 0;
+    uint64_t checksum = 0;
+    Fold(unit->rootModule, resolved, checksum);
+
+    printf("%zu names in %d modules\n", resolved, moduleCount);
+    Report("NameResolver (flat scopes)", flat, resolved);
+    Report("scope chain of hash maps", maps, resolved);
+
+    if (!ok || resolved != mapResolved || checksum != mapChecksum) {
+        printf("MISMATCH\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Numeric literal corpus: integers, decimals and scientific notation.
+// Compares the lexer against the old mantissa * pow(10.0L, exponent) conversion,
+// for speed and for the number of results that differ from correctly rounded ones.
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Lexer.h"
+
+// the conversion GetNumberToken used before, minus the lexing
+static double OldConvert(const char* p, const char* end, bool& isInteger, int64_t& integer)
+{
+    int64_t mantissa = 0;
+    int64_t exponent = 0;
+    bool hasDecimal = false;
+
+    for (; p != end; ++p)
+    {
+        if (*p >= '0' && *p <= '9') {
+            if (hasDecimal)
+                --exponent;
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        else if (*p == '.' && !hasDecimal) {
+            hasDecimal = true;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        int expSign = 1;
+
+        if (*p == '-') {
+            expSign = -1;
+            ++p;
+        }
+        else if (*p == '+') {
+            ++p;
+        }
+
+        int64_t exp = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p)
+            exp = exp * 10 + (*p - '0');
+
+        exponent += exp * expSign;
+    }
+
+    isInteger = exponent >= 0;
+
+    if (isInteger) {
+        integer = mantissa * (int64_t)(std::pow(10, exponent) + 0.5);
+        return 0;
+    }
+
+    return (double)(mantissa * std::pow(10.0L, exponent));
+}
+
+int main()
+{
+    auto& rng = BenchRandom();
+    std::string source;
+    std::vector<std::pair<size_t, size_t>> literals;
+
+    for (size_t i = 0; i < 3000000; ++i)
+    {
+        std::string lit;
+
+        switch (rng() % 4)
+        {
+        case 0:
+            lit = std::to_string(rng() % 1000000);
+            break;
+        case 1:
+            lit = std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100000);
+            break;
+        case 2:
+            lit = std::to_string(rng() % 10) + "." + std::to_string(rng()) + "e-" + std::to_string(rng() % 30);
+            break;
+        case 3:
+            lit = "0." + std::to_string(rng()) + std::to_string(rng());
+            break;
+        }
+
+        literals.emplace_back(source.size(), lit.size());
+        source += lit;
+        source += (i % 8 == 7) ? '\n' : ' ';
+    }
+
+    // accuracy of the old conversion
+    size_t inexact = 0;
+    size_t floats = 0;
+
+    for (auto& lit : literals)
+    {
+        auto p = source.data() + lit.first;
+        bool isInteger;
+        int64_t integer;
+        double value = OldConvert(p, p + lit.second, isInteger, integer);
+
+        if (!isInteger) {
+            ++floats;
+            inexact += value != strtod(std::string(p, lit.second).c_str(), nullptr);
+        }
+    }
+
+    printf("old conversion: %zu of %zu float literals not correctly rounded\n", inexact, floats);
+
+    auto old = Measure([&] {
+        double sum = 0;
+        for (auto& lit : literals) {
+            auto p = source.data() + lit.first;
+            bool isInteger;
+            int64_t integer;
+            sum += OldConvert(p, p + lit.second, isInteger, integer);
+        }
+        KeepAlive(sum);
+    });
+
+    auto buffer = SourceBuffer::FromMemory(source.data(), source.size());
+
+    auto lex = Measure([&] {
+        Lexer lexer(buffer);
+        double sum = 0;
+        for (auto tok = lexer.GetNextToken(); tok.type != TokenType::EndOfFile; tok = lexer.GetNextToken())
+            sum += tok.type == TokenType::Float ? tok.storage.floatValue : (double)tok.storage.intValue;
+        KeepAlive(sum);
+    });
+
+    Report("old conversion only", old, literals.size());
+    Report("lexer", lex, literals.size(), source.size());
+    return 0;
+}
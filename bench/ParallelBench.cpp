@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Scaling of Lexer::TokenizeParallel over 1-32 threads on a single large generated source
+// (256 MB, or argv[1] MB). Every run is checked against the sequential token stream.
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Lexer.h"
+
+static std::string MakeSource(size_t size)
+{
+    std::string text;
+    text.reserve(size + 4096);
+
+    while (text.size() < size)
+    {
+        text += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            text += "    var " + RandomIdentifier() + " = " + std::to_string(BenchRandom()() % 100000) + ";\n";
+            text += "    func " + RandomIdentifier() + "(int a, float b) {\n";
+            text += "        return a * (b + 1.25e2) - \"multi\n        line string\";\n";
+            text += "    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
+
+static bool Same(const TokenStream& a, const TokenStream& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a.type(i) != b.type(i) || a.position(i) != b.position(i))
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 256) << 20;
+    auto source = SourceBuffer::FromMemory(MakeSource(size));
+
+    TokenStream sequential;
+    auto baseline = Measure([&] { sequential = Lexer::TokenizeStream(source); }, 3);
+    Report("sequential", baseline, sequential.size(), source->size());
+
+    for (size_t threads : { 1, 2, 4, 8, 16, 32 })
+    {
+        TokenStream tokens;
+        auto seconds = Measure([&] { tokens = Lexer::TokenizeParallel(source, threads); }, 3);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%zu threads", threads);
+        Report(name, seconds, tokens.size(), source->size());
+        printf("  speedup %.2fx%s\n", baseline / seconds, Same(tokens, sequential) ? "" : "  MISMATCH");
+    }
+
+    return 0;
+}
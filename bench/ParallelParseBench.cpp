@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Scaling of parsing function bodies in parallel with the number of threads, on a source of
+// 16 MB (or argv[1] MB) in thousands of functions of uneven size, against the sequential parser.
+
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include "Bench.h"
+#include "../Parser.h"
+
+static std::string MakeSource(size_t size)
+{
+    std::string text;
+    text.reserve(size + 4096);
+
+    while (text.size() < size)
+    {
+        text += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 16; ++i)
+        {
+            text += "    int " + RandomIdentifier() + "(int a, int b)\n    {\n";
+
+            // a few bodies are much longer than the rest, for the work stealing to even out
+            int statements = BenchRandom()() % 16 == 0 ? 64 : 1 + BenchRandom()() % 8;
+
+            for (int j = 0; j < statements; ++j)
+                text += "        int c" + std::to_string(j) + " = (a + " + std::to_string(j) + ") * b - f(a, b * 2) / 3;\n";
+
+            text += "        return a;\n";
+            text += "    }\n";
+        }
+
+        text += "}\n";
+    }
+
+    return text;
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 16) << 20;
+    auto source = SourceBuffer::FromMemory(MakeSource(size));
+    auto tokens = Lexer::TokenizeStream(source);
+
+    auto sequential = Measure([&] {
+        Parser parser(tokens);
+        KeepAlive(parser.ParseTranslationUnit()->rootModule->modules.size());
+    }, 3);
+
+    Report("sequential", sequential, tokens.size(), source->size());
+
+    size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t threads = 1; threads <= maxThreads * 2; threads *= 2)
+    {
+        ThreadPool pool(threads);
+
+        auto parallel = Measure([&] {
+            Parser parser(tokens);
+            KeepAlive(parser.ParseTranslationUnit(pool)->rootModule->modules.size());
+        }, 3);
+
+        auto name = std::to_string(threads) + " threads";
+        Report(name.c_str(), parallel, tokens.size(), source->size());
+    }
+
+    return 0;
+}
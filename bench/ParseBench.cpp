@@ -0,0 +1,34 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Lexing and parsing fused into one pass (the Parser pulling tokens from the Lexer) against
+// tokenizing the whole source into a TokenStream first, on a 64 MB (or argv[1] MB) source.
+
+#include <string>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 64) << 20;
+    auto source = SourceBuffer::FromMemory(MakeModuleSource(size));
+    size_t tokenCount = Lexer::TokenizeStream(source).size();
+
+    // the AST is freed inside each timed run, so both include building and destroying it
+    auto fused = Measure([&] {
+        Parser parser(source);
+        KeepAlive(parser.ParseTranslationUnit()->rootModule->modules.size());
+    }, 3);
+
+    auto separate = Measure([&] {
+        Parser parser(Lexer::TokenizeStream(source));
+        KeepAlive(parser.ParseTranslationUnit()->rootModule->modules.size());
+    }, 3);
+
+    Report("fused lexer and parser", fused, tokenCount, source->size());
+    Report("token stream, then parser", separate, tokenCount, source->size());
+    return 0;
+}
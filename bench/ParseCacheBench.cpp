@@ -0,0 +1,130 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Cold and warm runs of the parse cache over a corpus of 512 (or argv[1]) files of 128 KB,
+// against parsing without a cache, and the speed of the content hash the cache is keyed by.
+// Also round-trips one 200k operand chain, and 200k nested calls, through the cache, which
+// must come back as the same tree without overflowing the stack.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include "Bench.h"
+#include "../Parser.h"
+#include "../ParseCache.h"
+
+static std::string DeepSource(size_t depth)
+{
+    std::string text = "int chain = 1";
+    text.reserve(depth * 7 + 32);
+
+    for (size_t i = 1; i < depth; ++i)
+        text += " + 1";
+
+    text += ";\nint calls = ";
+
+    for (size_t i = 0; i < depth; ++i)
+        text += "f(";
+
+    return text + "1" + std::string(depth, ')') + ";\n";
+}
+
+// stores the tree of 'text' in 'cache', loads it back, and checks they're the same
+static bool RoundTrip(ParseCache& cache, const std::string& text)
+{
+    auto source = SourceBuffer::FromMemory(text);
+    Parser parser(source);
+    auto parsed = parser.ParseTranslationUnit();
+
+    cache.Store(*source, *parsed);
+    auto loaded = cache.Load(*source);
+
+    return loaded && FlatAST::FromTree(*loaded).Serialize() == FlatAST::FromTree(*parsed).Serialize();
+}
+
+int main(int argc, char** argv)
+{
+    namespace fs = std::filesystem;
+
+    size_t fileCount = argc > 1 ? strtoull(argv[1], nullptr, 10) : 512;
+    auto root = fs::temp_directory_path() / "ParseCacheBench";
+    auto corpus = root / "corpus";
+    auto cacheDir = root / "cache";
+
+    fs::remove_all(root);
+    fs::create_directories(corpus);
+
+    std::vector<std::string> files;
+    size_t totalBytes = 0;
+
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        auto path = (corpus / ("f" + std::to_string(i) + ".src")).string();
+        auto text = MakeModuleSource(128 * 1024);
+        std::ofstream(path, std::ios::binary) << text;
+        files.push_back(path);
+        totalBytes += text.size();
+    }
+
+    auto parseAll = [&](ParseCache* cache) {
+        for (auto& file : files)
+        {
+            auto source = SourceBuffer::FromFile(file);
+            auto unit = cache ? cache->Load(*source) : nullptr;
+
+            if (!unit)
+            {
+                Parser parser(source);
+                unit = parser.ParseTranslationUnit();
+
+                if (cache)
+                    cache->Store(*source, *unit);
+            }
+
+            KeepAlive(unit->rootModule->modules.size());
+        }
+    };
+
+    auto uncached = Measure([&] { parseAll(nullptr); }, 3);
+
+    // each cold run starts from an empty cache
+    auto cold = Measure([&] {
+        fs::remove_all(cacheDir);
+        ParseCache cache(cacheDir.string());
+        parseAll(&cache);
+    }, 3);
+
+    ParseCache cache(cacheDir.string());
+    auto warm = Measure([&] { parseAll(&cache); }, 3);
+
+    auto source = SourceBuffer::FromFile(files[0]);
+    auto hash = Measure([&] {
+        for (int i = 0; i < 100; ++i)
+            KeepAlive(ParseCache::HashSource(*source));
+    });
+
+    auto stats = cache.statistics();
+
+    auto deep = Measure([&] {
+        if (!RoundTrip(cache, DeepSource(200000))) {
+            fprintf(stderr, "deep tree changed in the cache\n");
+            exit(1);
+        }
+    }, 1);
+
+    Report("no cache", uncached, fileCount, totalBytes);
+    Report("cold cache (parse and store)", cold, fileCount, totalBytes);
+    Report("warm cache (load)", warm, fileCount, totalBytes);
+    Report("content hash", hash, 100, source->size() * 100);
+    Report("deep tree (store and load)", deep, 1);
+    printf("warm runs: %zu hits, %zu misses, %.1f MB loaded for %.1f MB of source\n",
+           stats.hits, stats.misses, stats.bytesLoaded / 1e6, totalBytes * 3 / 1e6);
+
+    fs::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Dumping the syntax tree of a 16 MB (or argv[1] MB) source to a file: ASTNode::Print into a
+// stringstream and then out through stream.str(), against ASTPrinter in each of its formats.
+
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+#include "../ASTPrinter.h"
+#include "../OutputBuffer.h"
+
+#ifdef _WIN32
+#define fileno _fileno
+#endif
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 16) << 20;
+    auto source = SourceBuffer::FromMemory(MakeModuleSource(size));
+
+    Parser parser(source);
+    auto unit = parser.ParseTranslationUnit();
+
+    FILE* file = tmpfile();
+    int fd = fileno(file);
+    size_t bytes = 0;
+
+    auto stringstream = Measure([&] {
+        std::stringstream stream;
+        unit->Print(stream, 0, 2);
+        auto text = stream.str();
+        fwrite(text.data(), 1, text.size(), file);
+        fflush(file);
+        bytes = text.size();
+    }, 3);
+
+    Report("Print into stringstream", stringstream, 1, bytes);
+
+    auto formats = { ASTPrinter::Format::Tree, ASTPrinter::Format::Json, ASTPrinter::Format::SExpression };
+    const char* names[] = { "ASTPrinter, tree", "ASTPrinter, json", "ASTPrinter, sexpr" };
+    int i = 0;
+
+    for (auto format : formats)
+    {
+        std::string text;
+        {
+            OutputBuffer out(text);
+            ASTPrinter(out, format, 2).Print(*unit);
+        }
+
+        auto seconds = Measure([&] {
+            OutputBuffer out(fd);
+            ASTPrinter(out, format, 2).Print(*unit);
+            out.Flush();
+        }, 3);
+
+        Report(names[i++], seconds, 1, text.size());
+    }
+
+    fclose(file);
+    return 0;
+}
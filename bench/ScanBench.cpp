@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Throughput of the whitespace, identifier and string body scanning kernels for each
+// instruction set, over runs of realistic lengths, and of the whole lexer.
+
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "../Lexer.h"
+
+typedef const char* (*ScanFunc)(const char*, const char*);
+
+// scans every run in 'text', where runs are separated by a single stop byte
+static double ScanRuns(ScanFunc scan, const std::string& text)
+{
+    return Measure([&] {
+        auto p = text.data();
+        auto end = p + text.size();
+        size_t runs = 0;
+
+        while (p < end) {
+            p = scan(p, end) + 1;
+            ++runs;
+        }
+
+        KeepAlive(runs);
+    });
+}
+
+static std::string MakeRuns(const char* runChars, char stop, size_t minLength, size_t maxLength, size_t totalSize)
+{
+    auto& rng = BenchRandom();
+    auto count = strlen(runChars);
+
+    std::string ret;
+    ret.reserve(totalSize + maxLength + 1);
+
+    while (ret.size() < totalSize)
+    {
+        size_t length = minLength + rng() % (maxLength - minLength + 1);
+        for (size_t i = 0; i < length; ++i)
+            ret += runChars[rng() % count];
+        ret += stop;
+    }
+
+    return ret;
+}
+
+int main()
+{
+    const size_t size = 64 * 1024 * 1024;
+
+    auto whitespace = MakeRuns(" \n\t", 'x', 1, 40, size);
+    auto identifiers = MakeRuns("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789", ' ', 2, 24, size);
+    auto strings = MakeRuns("abcdefghijklmnopqrstuvwxyz ,.:;!?0123456789", '\"', 8, 120, size);
+
+    std::vector<const ScanKernels*> kernelSets = { &ScanKernels::Scalar() };
+#ifdef SCAN_KERNELS_X86
+    kernelSets.push_back(&ScanKernels::SSE2());
+#endif
+#ifdef SCAN_KERNELS_AVX2
+    if (ScanKernels::Get().name == std::string("avx2"))
+        kernelSets.push_back(&ScanKernels::AVX2());
+#endif
+
+    for (auto kernels : kernelSets)
+    {
+        printf("%s\n", kernels->name);
+        Report("  whitespace", ScanRuns(kernels->SkipWhitespace, whitespace), whitespace.size(), whitespace.size());
+        Report("  identifiers", ScanRuns(kernels->SkipIdentifier, identifiers), identifiers.size(), identifiers.size());
+        Report("  string bodies", ScanRuns(kernels->SkipStringBody, strings), strings.size(), strings.size());
+    }
+
+    // whole lexer over an ASCII-heavy source, using the kernels selected for this CPU
+    std::string source;
+    auto& rng = BenchRandom();
+
+    while (source.size() < size)
+    {
+        source += "    int " + RandomIdentifier() + " = " + std::to_string(rng() % 1000) + " + " + RandomIdentifier() + ";\n";
+        if (rng() % 4 == 0)
+            source += "    print(\"" + RandomIdentifier(10, 60) + " " + RandomIdentifier(10, 60) + "\");\n";
+    }
+
+    auto buffer = SourceBuffer::FromMemory(source.data(), source.size());
+    size_t tokens = 0;
+
+    auto lex = Measure([&] {
+        Lexer lexer(buffer);
+        tokens = 0;
+        while (lexer.GetNextToken().type != TokenType::EndOfFile)
+            ++tokens;
+    }, 3);
+
+    printf("lexer (%s)\n", ScanKernels::Get().name);
+    Report("  tokens", lex, tokens, source.size());
+    return 0;
+}
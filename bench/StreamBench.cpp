@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Streams a generated source of 1 GB (or argv[1] MB) through the lexer in streaming mode and
+// reports the peak resident set size, then does the same for a fully materialized token vector
+// over a smaller source for comparison. The input is produced on the fly, so only the lexer's
+// window is ever in memory.
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Lexer.h"
+
+static std::string MakeChunk()
+{
+    std::string chunk;
+
+    while (chunk.size() < 60 * 1024)
+    {
+        chunk += "module " + RandomIdentifier() + "\n{\n";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            chunk += "    var " + RandomIdentifier() + " = " + std::to_string(BenchRandom()() % 100000) + ";\n";
+            chunk += "    func " + RandomIdentifier() + "(int a, float b) {\n";
+            chunk += "        return a * (b + 1.25e2) - \"str\\u00e9ing\";\n";
+            chunk += "    }\n";
+        }
+
+        chunk += "}\n";
+    }
+
+    return chunk;
+}
+
+// endless repetitions of 'chunk', cut off at 'total' bytes
+static sptr<SourceStream> GeneratedStream(const std::string& chunk, size_t total)
+{
+    size_t produced = 0;
+
+    return SourceStream::FromReader([&chunk, total, produced](char* dst, size_t capacity) mutable {
+        size_t n = 0;
+
+        while (n < capacity && produced < total)
+        {
+            size_t offset = produced % chunk.size();
+            size_t count = std::min({ capacity - n, chunk.size() - offset, total - produced });
+            memcpy(dst + n, chunk.data() + offset, count);
+            n += count;
+            produced += count;
+        }
+
+        return n;
+    }, "<generated>");
+}
+
+int main(int argc, char** argv)
+{
+    size_t streamSize = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 1024) << 20;
+    size_t memorySize = std::min(streamSize, (size_t)128 << 20);
+
+    auto chunk = MakeChunk();
+    size_t baseline = PeakMemory();
+    size_t tokenCount = 0;
+
+    auto streaming = Measure([&] {
+        Lexer lexer(GeneratedStream(chunk, streamSize));
+        tokenCount = 0;
+
+        while (lexer.GetNextToken().type != TokenType::EndOfFile)
+            ++tokenCount;
+    }, 1);
+
+    size_t streamingPeak = PeakMemory();
+
+    Report("streaming", streaming, tokenCount, streamSize);
+    printf("  %zu MB input, peak RSS %.1f MB (%.1f MB before lexing)\n\n",
+           streamSize >> 20, streamingPeak / 1e6, baseline / 1e6);
+
+    std::string text;
+    text.reserve(memorySize);
+
+    while (text.size() < memorySize)
+        text.append(chunk, 0, std::min(chunk.size(), memorySize - text.size()));
+
+    auto source = SourceBuffer::FromMemory(std::move(text));
+    std::vector<Token> tokens;
+
+    auto materialized = Measure([&] {
+        tokens.clear();
+        Lexer lexer(source);
+        lexer.Tokenize(tokens);
+    }, 1);
+
+    Report("in memory, token vector", materialized, tokens.size(), memorySize);
+    printf("  %zu MB input, peak RSS %.1f MB\n", memorySize >> 20, PeakMemory() / 1e6);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*---------------------------------------------------------------------------------------------
+*  Copyright (c) 2020 Nicolas Jinchereau. All rights reserved.
+*  Licensed under the MIT License. See License.txt in the project root for license information.
+*--------------------------------------------------------------------------------------------*/
+
+// Whole-tree traversal through the virtual ASTWalker against the switch dispatched StaticASTWalker
+// and a hand written switch, on a parsed source of at least a million nodes (argv[1] MB, 16 by
+// default). Each pass counts the nodes and sums the integer literals, so their results must match.
+
+#include <string>
+#include <cstdlib>
+#include "Bench.h"
+#include "../Parser.h"
+#include "../ASTWalker.h"
+#include "../StaticASTVisitor.h"
+
+struct Totals
+{
+    size_t nodes = 0;
+    int64_t integers = 0;
+
+    bool operator==(const Totals& other) const {
+        return nodes == other.nodes && integers == other.integers;
+    }
+};
+
+// virtual dispatch. every node goes through Accept and a Visit override.
+
+class DynamicCounter : public ASTWalker
+{
+public:
+    using ASTWalker::Visit;
+    Totals totals;
+
+    void Visit(ASTNode* node) override { ++totals.nodes; }
+    void Visit(TranslationUnit* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(ModuleDefinition* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(FunctionDefinition* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(FunctionParameter* node) override { ++totals.nodes; }
+    void Visit(VariableDeclaration* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(BlockStatement* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(DeclarationStatement* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(ExpressionStatement* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(ReturnStatement* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(BinaryExpression* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(FunctionExpression* node) override { ++totals.nodes; ASTWalker::Visit(node); }
+    void Visit(VariableExpression* node) override { ++totals.nodes; }
+    void Visit(IntegerExpression* node) override { ++totals.nodes; totals.integers += node->value; }
+};
+
+// static dispatch. the fallbacks send everything but integers to VisitNode.
+
+class StaticCounter : public StaticASTWalker<StaticCounter>
+{
+public:
+    Totals totals;
+
+    void VisitNode(ASTNode* node) { ++totals.nodes; }
+    void VisitIntegerExpression(IntegerExpression* node) { ++totals.nodes; totals.integers += node->value; }
+};
+
+// hand written
+
+static void Count(ASTNode* node, Totals& totals)
+{
+    ++totals.nodes;
+
+    switch (node->kind)
+    {
+    case ASTNodeKind::TranslationUnit:
+        Count(static_cast<TranslationUnit*>(node)->rootModule, totals);
+        break;
+    case ASTNodeKind::ModuleDefinition: {
+        auto mod = static_cast<ModuleDefinition*>(node);
+        for (auto var : mod->variables) Count(var, totals);
+        for (auto func : mod->functions) Count(func, totals);
+        for (auto m : mod->modules) Count(m, totals);
+        break;
+    }
+    case ASTNodeKind::FunctionDefinition: {
+        auto func = static_cast<FunctionDefinition*>(node);
+        for (auto param : func->params) Count(param, totals);
+        Count(func->GetBody(), totals);
+        break;
+    }
+    case ASTNodeKind::VariableDeclaration:
+        if (auto init = static_cast<VariableDeclaration*>(node)->initializer)
+            Count(init, totals);
+        break;
+    case ASTNodeKind::BlockStatement:
+        for (auto stmt : static_cast<BlockStatement*>(node)->statements)
+            Count(stmt, totals);
+        break;
+    case ASTNodeKind::DeclarationStatement:
+        Count(static_cast<DeclarationStatement*>(node)->variableDeclaration, totals);
+        break;
+    case ASTNodeKind::ExpressionStatement:
+        Count(static_cast<ExpressionStatement*>(node)->expression, totals);
+        break;
+    case ASTNodeKind::ReturnStatement:
+        if (auto exp = static_cast<ReturnStatement*>(node)->expression)
+            Count(exp, totals);
+        break;
+    case ASTNodeKind::BinaryExpression:
+        Count(static_cast<BinaryExpression*>(node)->left, totals);
+        Count(static_cast<BinaryExpression*>(node)->right, totals);
+        break;
+    case ASTNodeKind::FunctionExpression:
+        for (auto arg : static_cast<FunctionExpression*>(node)->arguments)
+            Count(arg, totals);
+        break;
+    case ASTNodeKind::IntegerExpression:
+        totals.integers += static_cast<IntegerExpression*>(node)->value;
+        break;
+    default:
+        break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 16) << 20;
+    auto source = SourceBuffer::FromMemory(MakeExpressionSource(size));
+
+    Parser parser(source);
+    auto unit = parser.ParseTranslationUnit();
+
+    Totals dynamicTotals, staticTotals, switchTotals;
+
+    auto dynamicTime = Measure([&] {
+        DynamicCounter counter;
+        unit->Accept(&counter);
+        dynamicTotals = counter.totals;
+    });
+
+    auto staticTime = Measure([&] {
+        StaticCounter counter;
+        counter.Traverse(unit.get());
+        staticTotals = counter.totals;
+    });
+
+    auto switchTime = Measure([&] {
+        switchTotals = Totals();
+        Count(unit.get(), switchTotals);
+    });
+
+    size_t count = switchTotals.nodes;
+    printf("%zu nodes\n", count);
+
+    Report("ASTWalker (virtual)", dynamicTime, count);
+    Report("StaticASTWalker (switch)", staticTime, count);
+    Report("hand written switch", switchTime, count);
+
+    if (!(dynamicTotals == switchTotals) || !(staticTotals == switchTotals)) {
+        printf("MISMATCH\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -5,22 +5,84 @@
 
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include "Lexer.h"
 #include "Parser.h"
+#include "BatchDriver.h"
+#include "ASTPrinter.h"
+#include "OutputBuffer.h"
+#include "NameResolver.h"
+#include "TypeChecker.h"
 using namespace std;
 
+// compiler-test                    parses test.src, prints its syntax tree and any name or type errors
+// compiler-test [options] paths..  parses every file, directory (*.src) or @list given, in parallel
+//   -j <threads>   number of threads, the number of hardware threads by default
+//   --print        print the syntax tree of every file
+//   --format <f>   print the syntax tree of every file as 'tree', 'json' or 'sexpr'
+//   --cache <dir>  load files that haven't changed since the last run from a parse cache in 'dir'
+static int RunBatch(int argc, char** argv)
+{
+    BatchDriver::Options options;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+
+        if (arg == "-j" && i + 1 < argc)
+            options.threadCount = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--print")
+            options.printTrees = true;
+        else if (arg == "--format" && i + 1 < argc) {
+            options.format = ASTPrinter::ParseFormat(argv[++i]);
+            options.printTrees = true;
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+            options.cacheDirectory = argv[++i];
+        else
+            paths.push_back(arg);
+    }
+
+    BatchDriver driver(options);
+
+    for (auto& path : paths)
+        driver.Add(path);
+
+    OutputBuffer out(1); // stdout
+    return driver.Run(out) == 0 ? 0 : 1;
+}
+
 int main(int argc, char** argv)
 {
     try
     {
+        if (argc > 1)
+            return RunBatch(argc, argv);
+
         auto filename = "test.src";
         Parser parser(filename);
         auto translationUnit = parser.ParseTranslationUnit();
 
-        std::stringstream stream;
-        translationUnit->Print(stream, 0, 2);
+        OutputBuffer out(1); // stdout
+        ASTPrinter(out, ASTPrinter::Format::Tree, 2).Print(*translationUnit);
+        out.Write('\n');
+        out.Flush();
+
+        NameResolver resolver;
+        if (!resolver.Resolve(*translationUnit))
+        {
+            for (auto& error : resolver.errors())
+                cout << "error: " << error << endl;
+        }
 
-        cout << stream.str() << endl;
+        TypeTable types;
+        TypeChecker checker(types);
+        if (!checker.Check(*translationUnit, resolver))
+        {
+            for (auto& error : checker.errors())
+                cout << "error: " << error << endl;
+        }
     }
     catch (exception& ex)
     {